@@ -37,12 +37,18 @@ struct PenData
 	wxPen Black1px = wxPen(*wxBLACK, 1);
 	wxPen White1px = wxPen(*wxWHITE, 1);
 	wxPen Transparent1px = *wxTRANSPARENT_PEN;
+	wxPen Green2px = wxPen(*wxGREEN, 2);
+	wxPen Red2px = wxPen(*wxRED, 2);
+	wxPen Blue2px = wxPen(*wxBLUE, 2);
 };
 static PenData* pens;
 
 PEN(Black1px)
 PEN(White1px)
 PEN(Transparent1px)
+PEN(Green2px)
+PEN(Red2px)
+PEN(Blue2px)
 
 // ====================================================================================================================
 // Files.
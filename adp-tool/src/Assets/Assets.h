@@ -21,6 +21,9 @@ struct Pens
 	static const wxPen& Black1px();
 	static const wxPen& White1px();
 	static const wxPen& Transparent1px();
+	static const wxPen& Green2px();
+	static const wxPen& Red2px();
+	static const wxPen& Blue2px();
 };
 
 struct Files
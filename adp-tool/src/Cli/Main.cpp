@@ -0,0 +1,625 @@
+#include "Adp.h"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <nlohmann/json.hpp>
+using json = nlohmann::json;
+
+#include "Model/Device.h"
+#include "Model/Emulator.h"
+#include "Model/LatencyStats.h"
+#include "Model/Log.h"
+#include "Model/Utils.h"
+
+using namespace std;
+using namespace chrono;
+
+namespace adp {
+
+static const char* TOOL_NAME = "adp-cli";
+
+// Same interval as the update timer of the GUI.
+constexpr int UPDATE_INTERVAL_MS = 10;
+
+// How long one-shot commands wait for a pad to show up.
+constexpr int DEFAULT_CONNECT_TIMEOUT_MS = 3000;
+
+static atomic<bool> stopRequested = false;
+
+static void OnSignal(int)
+{
+    stopRequested = true;
+}
+
+static json ToJson(const LatencyDistribution& distribution)
+{
+    json j;
+    j["count"] = distribution.count;
+    j["p50Us"] = distribution.p50;
+    j["p99Us"] = distribution.p99;
+    j["maxUs"] = distribution.max;
+    return j;
+}
+
+static json ToJson(const LatencySummary& summary)
+{
+    json j;
+    j["pressLatency"] = ToJson(summary.pressLatency);
+    j["reportInterval"] = ToJson(summary.reportInterval);
+    j["reportJitter"] = ToJson(summary.reportJitter);
+    j["hostInterval"] = ToJson(summary.hostInterval);
+    return j;
+}
+
+static json ToJson(const PadStats& stats)
+{
+    static const char* StageNames[NUM_STATS_STAGES] =
+    {
+        "mainLoop", "padUpdate", "lightsRender", "ledWrite", "eepromWrite",
+    };
+
+    json j;
+    for (int i = 0; i < NUM_STATS_STAGES; ++i)
+    {
+        j["stages"][StageNames[i]]["averageUs"] = stats.stages[i].averageMicros;
+        j["stages"][StageNames[i]]["maxUs"] = stats.stages[i].maxMicros;
+        j["stages"][StageNames[i]]["runsPerSecond"] = stats.stages[i].runsPerSecond;
+    }
+    j["adcConversionsPerSecond"] = stats.adcConversionsPerSecond;
+    j["reportRate"] = stats.reportRate;
+    j["missedFrames"] = stats.missedFrames;
+    return j;
+}
+
+// ====================================================================================================================
+// Command line tool.
+// ====================================================================================================================
+
+class Cli
+{
+public:
+    bool verbose = false;
+    int connectTimeout = DEFAULT_CONNECT_TIMEOUT_MS;
+    int deviceIndex = 0;
+
+    int Run(const vector<string>& args)
+    {
+        if (args.empty())
+            return Usage();
+
+        auto& command = args[0];
+
+        if (command == "daemon")
+            return RunDaemon();
+
+        bool validCommand =
+            (command == "list-devices" && args.size() == 1) ||
+            (command == "dump-state" && args.size() == 1) ||
+            (command == "apply-profile" && args.size() == 2) ||
+            (command == "stream-sensors" && args.size() <= 2) ||
+            (command == "record" && (args.size() == 2 || args.size() == 3)) ||
+            (command == "measure-latency" && args.size() <= 3);
+
+        if (!validCommand)
+            return Usage();
+
+        if (!WaitForDevice())
+        {
+            fprintf(stderr, "%s: no pad connected\n", TOOL_NAME);
+            return 1;
+        }
+
+        if (command == "list-devices")
+        {
+            ListDevices();
+            return 0;
+        }
+
+        if (command == "dump-state")
+            return DumpState() ? 0 : 1;
+
+        if (command == "apply-profile")
+            return ApplyProfile(args[1]) ? 0 : 1;
+
+        if (command == "record")
+            return Record(args[1], args.size() == 3 ? atof(args[2].c_str()) : 0.0) ? 0 : 1;
+
+        if (command == "measure-latency")
+        {
+            double seconds = args.size() >= 2 ? atof(args[1].c_str()) : 10.0;
+            return MeasureLatency(seconds, args.size() == 3 ? args[2] : string()) ? 0 : 1;
+        }
+
+        myStreamRate = args.size() == 2 ? atoi(args[1].c_str()) : 100;
+        if (myStreamRate <= 0)
+            return Usage();
+
+        Device::SetSensorStream(true);
+        while (!stopRequested && Device::Pad())
+        {
+            Tick();
+            StreamSensors();
+            this_thread::sleep_for(milliseconds(UPDATE_INTERVAL_MS));
+        }
+        return 0;
+    }
+
+private:
+    int Usage()
+    {
+        fprintf(stderr,
+            "usage: %s [--verbose] [--log-file <file>] [--timeout <ms>] [--device <index>]\n"
+            "          [--replay <capture> [--speed <x>]] [--emulate <hz> [--latency <us>] [--jitter <us>]] <command>\n"
+            "\n"
+            "commands:\n"
+            "  list-devices             print the connected pads, the first pad has index 0\n"
+            "  dump-state               print the configuration and live state of the pad as json\n"
+            "  apply-profile <file>     load a profile onto the pad and save it to its eeprom\n"
+            "  stream-sensors [hz]      print sensor values as csv lines until interrupted (default 100 hz)\n"
+            "  record <file> [seconds]  record raw sensor reports to a capture file until interrupted\n"
+            "  measure-latency [seconds] [file]\n"
+            "                           measure input latency on the pad (default 10 seconds) and print it as json,\n"
+            "                           the results are appended to a csv file if given, needs firmware 1.5\n"
+            "  daemon                   stay connected and read the commands above from stdin, one per line\n"
+            "                           'select <index>' picks the pad that following commands apply to\n"
+            "                           'measure-latency' keeps measuring, dump-state shows the results\n"
+            "                           'stop' ends streaming, recording and measuring\n"
+            "\n"
+            "--verbose prints the log to stderr, including debug messages like every report transfer\n"
+            "--log-file writes the log to a file as well, at the same level\n"
+            "--replay connects a capture file instead of searching for pads, --speed scales its playback rate\n"
+            "--emulate connects a simulated pad reporting at 1000-8000 hz instead of searching for pads,\n"
+            "          feature reports take the latency plus or minus the jitter\n",
+            TOOL_NAME);
+        return 2;
+    }
+
+    DeviceChanges Tick()
+    {
+        auto changes = Device::Update();
+
+        wstring debugMessage = Device::ReadDebug();
+        if (!debugMessage.empty())
+            Log::Writef(L"\\/ \\/ \\/ Debug \\/ \\/ \\/\n%ls", debugMessage.c_str());
+
+        // Without a log tab, the log goes to stderr.
+        LogMessage message;
+        while (verbose && Log::Read(myNextLogMessage, message))
+            fprintf(stderr, "%s\n", narrow(message.text.data(), message.text.size()).c_str());
+
+        return changes;
+    }
+
+    bool WaitForDevice()
+    {
+        auto deadline = steady_clock::now() + milliseconds(connectTimeout);
+        while (!stopRequested && Device::NumDevices() <= deviceIndex && steady_clock::now() < deadline)
+        {
+            Tick();
+            this_thread::sleep_for(milliseconds(UPDATE_INTERVAL_MS));
+        }
+
+        Device::SelectDevice(deviceIndex);
+        return Device::SelectedDevice() == deviceIndex && Device::Pad() != nullptr;
+    }
+
+    void ListDevices()
+    {
+        for (int i = 0; i < Device::NumDevices(); ++i)
+        {
+            auto pad = Device::Pad(i);
+            const wchar_t* board = BoardTypeToString(pad->boardType);
+            printf("%i%s %s (%s, v%u.%u)\n", i, i == Device::SelectedDevice() ? "*" : ":", pad->name.c_str(),
+                narrow(board, wcslen(board)).c_str(), pad->firmwareVersion.major, pad->firmwareVersion.minor);
+        }
+        fflush(stdout);
+    }
+
+    bool DumpState()
+    {
+        auto pad = Device::Pad();
+        if (!pad)
+        {
+            fprintf(stderr, "%s: no pad connected\n", TOOL_NAME);
+            return false;
+        }
+
+        // The polling rate is measured over a second, give it time to settle.
+        auto settleUntil = steady_clock::now() + milliseconds(1100);
+        while (!stopRequested && Device::Pad() && steady_clock::now() < settleUntil)
+        {
+            Tick();
+            this_thread::sleep_for(milliseconds(UPDATE_INTERVAL_MS));
+        }
+
+        pad = Device::Pad();
+        if (!pad)
+            return false;
+
+        json j;
+        Device::SaveProfile(j, DGP_ALL);
+
+        const wchar_t* board = BoardTypeToString(pad->boardType);
+        j["state"]["board"] = narrow(board, wcslen(board));
+        j["state"]["firmwareVersion"] = "v" + to_string(pad->firmwareVersion.major) + "." + to_string(pad->firmwareVersion.minor);
+        j["state"]["numButtons"] = pad->numButtons;
+        j["state"]["pollingRate"] = Device::PollingRate();
+        j["state"]["reportRate"] = pad->reportRate;
+        j["state"]["missedFrames"] = pad->missedFrames;
+        j["state"]["unsavedChanges"] = Device::HasUnsavedChanges();
+
+        LatencySummary latency;
+        if (Device::Latency(latency))
+            j["state"]["latency"] = ToJson(latency);
+
+        PadStats stats;
+        if (Device::Stats(stats))
+            j["state"]["stats"] = ToJson(stats);
+
+        j["state"]["sensors"] = json::array();
+        for (int i = 0; i < pad->numSensors; ++i)
+        {
+            auto sensor = Device::Sensor(i);
+            j["state"]["sensors"][i]["value"] = sensor->value;
+            j["state"]["sensors"][i]["pressed"] = sensor->pressed;
+        }
+
+        printf("%s\n", j.dump(4).c_str());
+        fflush(stdout);
+        return true;
+    }
+
+    bool ApplyProfile(const string& path)
+    {
+        if (!Device::Pad())
+        {
+            fprintf(stderr, "%s: no pad connected\n", TOOL_NAME);
+            return false;
+        }
+
+        ifstream fileStream(path);
+        if (!fileStream.is_open())
+        {
+            fprintf(stderr, "%s: could not read profile: %s\n", TOOL_NAME, path.c_str());
+            return false;
+        }
+
+        try {
+            json j;
+            fileStream >> j;
+            Device::LoadProfile(j, DGP_ALL);
+        } catch (exception& e) {
+            fprintf(stderr, "%s: could not read profile: %s\n", TOOL_NAME, e.what());
+            return false;
+        }
+
+        // Don't wait for the delayed save, the daemon or process might be stopped right after.
+        Device::SaveChanges();
+        bool written = Device::FlushWrites();
+        Tick();
+
+        if (!written)
+            fprintf(stderr, "%s: could not write the profile to the pad\n", TOOL_NAME);
+        return written;
+    }
+
+    bool Record(const string& path, double seconds)
+    {
+        if (!Device::StartRecording(path))
+        {
+            fprintf(stderr, "%s: could not record to %s\n", TOOL_NAME, path.c_str());
+            return false;
+        }
+
+        auto start = steady_clock::now();
+        while (!stopRequested && Device::Pad() && Device::IsRecording())
+        {
+            if (seconds > 0 && duration<double>(steady_clock::now() - start).count() >= seconds)
+                break;
+
+            Tick();
+            this_thread::sleep_for(milliseconds(UPDATE_INTERVAL_MS));
+        }
+
+        // Samples that came in since the last tick are written too.
+        Tick();
+        Device::StopRecording();
+        return true;
+    }
+
+    bool MeasureLatency(double seconds, const string& path)
+    {
+        if (!Device::SetInputTiming(true))
+        {
+            fprintf(stderr, "%s: the pad does not support latency measurement\n", TOOL_NAME);
+            return false;
+        }
+
+        if (!Device::FlushWrites())
+        {
+            fprintf(stderr, "%s: could not start latency measurement on the pad\n", TOOL_NAME);
+            Device::SetInputTiming(false);
+            return false;
+        }
+
+        auto start = steady_clock::now();
+        while (!stopRequested && Device::Pad() && duration<double>(steady_clock::now() - start).count() < seconds)
+        {
+            Tick();
+            this_thread::sleep_for(milliseconds(UPDATE_INTERVAL_MS));
+        }
+
+        Tick();
+        LatencySummary latency;
+        if (!Device::Latency(latency))
+            return false;
+
+        bool exported = path.empty() || Device::ExportLatency(path);
+        Device::SetInputTiming(false);
+        bool stopped = Device::FlushWrites();
+
+        printf("%s\n", ToJson(latency).dump(4).c_str());
+        fflush(stdout);
+
+        if (!exported)
+            fprintf(stderr, "%s: could not export to %s\n", TOOL_NAME, path.c_str());
+        if (!stopped)
+            fprintf(stderr, "%s: could not turn off latency measurement on the pad\n", TOOL_NAME);
+        return exported && stopped;
+    }
+
+    void StreamSensors()
+    {
+        auto pad = Device::Pad();
+        if (!pad || myStreamRate <= 0)
+            return;
+
+        auto now = steady_clock::now();
+        if (now < myNextStreamLine)
+            return;
+
+        if (myNextStreamLine == steady_clock::time_point())
+        {
+            myStreamStart = now;
+            myNextStreamLine = now;
+            printf("time_ms");
+            for (int i = 0; i < pad->numSensors; ++i)
+                printf(",sensor%i", i + 1);
+            printf("\n");
+        }
+
+        // Lines are spaced by the requested rate, but falling behind does not cause a burst to catch up.
+        auto interval = microseconds(1000000 / myStreamRate);
+        myNextStreamLine = max(myNextStreamLine, now - interval) + interval;
+
+        printf("%lli", (long long)duration_cast<milliseconds>(now - myStreamStart).count());
+        for (int i = 0; i < pad->numSensors; ++i)
+            printf(",%.4f", Device::Sensor(i)->value);
+        printf("\n");
+        fflush(stdout);
+    }
+
+    void StopStream()
+    {
+        myStreamRate = 0;
+        myNextStreamLine = steady_clock::time_point();
+
+        // The pad goes back to button-only reports, unless it is recording or measuring latency.
+        Device::SetSensorStream(false);
+    }
+
+    void ExecuteLine(const string& line)
+    {
+        istringstream stream(line);
+        string command, argument;
+        stream >> command;
+        getline(stream >> ws, argument);
+
+        if (command.empty())
+            return;
+
+        if (command == "list-devices")
+        {
+            ListDevices();
+        }
+        else if (command == "select" && !argument.empty())
+        {
+            StopStream();
+            Device::SelectDevice(atoi(argument.c_str()));
+            ListDevices();
+        }
+        else if (command == "dump-state")
+        {
+            DumpState();
+        }
+        else if (command == "apply-profile" && !argument.empty())
+        {
+            if (ApplyProfile(argument))
+                printf("ok\n");
+        }
+        else if (command == "record" && !argument.empty())
+        {
+            if (Device::StartRecording(argument))
+                printf("ok\n");
+        }
+        else if (command == "measure-latency")
+        {
+            if (Device::SetInputTiming(true))
+                printf("ok\n");
+        }
+        else if (command == "stream-sensors")
+        {
+            StopStream();
+            myStreamRate = argument.empty() ? 100 : atoi(argument.c_str());
+            Device::SetSensorStream(myStreamRate > 0);
+        }
+        else if (command == "stop")
+        {
+            StopStream();
+            Device::StopRecording();
+            if (Device::IsTimingInput())
+                Device::SetInputTiming(false);
+        }
+        else if (command == "quit")
+        {
+            stopRequested = true;
+        }
+        else
+        {
+            fprintf(stderr, "%s: unknown command: %s\n", TOOL_NAME, line.c_str());
+        }
+        fflush(stdout);
+    }
+
+    int RunDaemon()
+    {
+        // Reading stdin blocks, so it happens on its own thread. The thread is left behind on exit.
+        thread inputThread([this]()
+        {
+            string line;
+            while (getline(cin, line))
+            {
+                lock_guard<mutex> lock(myInputMutex);
+                myInputLines.push(line);
+            }
+            stopRequested = true;
+        });
+        inputThread.detach();
+
+        while (!stopRequested)
+        {
+            auto changes = Tick();
+
+            // Selecting a device is reported as a device change too, only report actual connects and disconnects.
+            if ((changes & DCF_DEVICE) && Device::NumDevices() != myNumDevicesShown)
+            {
+                myNumDevicesShown = Device::NumDevices();
+                printf("devices: %i\n", myNumDevicesShown);
+                ListDevices();
+                StopStream();
+            }
+
+            while (true)
+            {
+                string line;
+                {
+                    lock_guard<mutex> lock(myInputMutex);
+                    if (myInputLines.empty())
+                        break;
+                    line = myInputLines.front();
+                    myInputLines.pop();
+                }
+                ExecuteLine(line);
+            }
+
+            StreamSensors();
+
+            this_thread::sleep_for(milliseconds(UPDATE_INTERVAL_MS));
+        }
+
+        return 0;
+    }
+
+    uint64_t myNextLogMessage = 0;
+    int myNumDevicesShown = 0;
+    int myStreamRate = 0;
+    steady_clock::time_point myStreamStart;
+    steady_clock::time_point myNextStreamLine;
+    mutex myInputMutex;
+    queue<string> myInputLines;
+};
+
+}; // namespace adp.
+
+int main(int argc, char** argv)
+{
+    using namespace adp;
+
+    Cli cli;
+    vector<string> args;
+    string logPath;
+    string replayPath;
+    double replaySpeed = 1.0;
+    bool emulate = false;
+    EmulatorSettings emulator;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--verbose") == 0)
+            cli.verbose = true;
+        else if (strcmp(argv[i], "--log-file") == 0 && i + 1 < argc)
+            logPath = argv[++i];
+        else if (strcmp(argv[i], "--timeout") == 0 && i + 1 < argc)
+            cli.connectTimeout = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--device") == 0 && i + 1 < argc)
+            cli.deviceIndex = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+            replayPath = argv[++i];
+        else if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc)
+            replaySpeed = atof(argv[++i]);
+        else if (strcmp(argv[i], "--emulate") == 0 && i + 1 < argc)
+        {
+            emulate = true;
+            emulator.reportRate = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--latency") == 0 && i + 1 < argc)
+            emulator.latencyUs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--jitter") == 0 && i + 1 < argc)
+            emulator.jitterUs = atoi(argv[++i]);
+        else
+            args.push_back(argv[i]);
+    }
+
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+
+    Log::Init();
+    if (cli.verbose)
+        Log::SetLevel(LOG_DEBUG);
+    if (!logPath.empty() && !Log::SetFile(logPath.c_str()))
+    {
+        fprintf(stderr, "%s: could not open log file %s\n", TOOL_NAME, logPath.c_str());
+        Log::Shutdown();
+        return 1;
+    }
+
+    Device::Init();
+
+    // Replays and emulated pads replace real pads, so they are device 0.
+    bool connected = true;
+    if (!replayPath.empty())
+    {
+        Device::SetSearching(false);
+        connected = Device::ReplayCapture(replayPath, replaySpeed);
+    }
+    else if (emulate)
+    {
+        Device::SetSearching(false);
+        connected = Device::ConnectEmulator(emulator);
+    }
+
+    if (!connected)
+    {
+        fprintf(stderr, "%s: could not connect the %s\n", TOOL_NAME, replayPath.empty() ? "emulator" : "capture");
+        Device::Shutdown();
+        Log::Shutdown();
+        return 1;
+    }
+
+    int result = cli.Run(args);
+
+    Device::Shutdown();
+    Log::Shutdown();
+
+    return result;
+}
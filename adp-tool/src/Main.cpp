@@ -1,6 +1,7 @@
 #include "Adp.h"
 #include "Main.h"
 
+#include <chrono>
 #include <iostream>
 #include <vector>
 #include <fstream>
@@ -24,16 +25,27 @@ using json = nlohmann::json;
 #include "View/MappingTab.h"
 #include "View/LightsTab.h"
 #include "View/DeviceTab.h"
+#include "View/LatencyTab.h"
+#include "View/DiagnosticsTab.h"
 #include "View/AboutTab.h"
 #include "View/LogTab.h"
 
+#include "Model/Emulator.h"
 #include "Model/Log.h"
 #include "Model/Updater.h"
 #include "View/UpdaterView.h"
 
 namespace adp {
 
-enum Ids { PROFILE_LOAD = 1, PROFILE_SAVE = 2, MENU_EXIT = 3};
+enum Ids { PROFILE_LOAD = 1, PROFILE_SAVE = 2, MENU_EXIT = 3, CAPTURE_RECORD = 4, CAPTURE_REPLAY = 5, DEVICE_SELECT = 100};
+
+// Number of connected pads that can be picked from the device menu.
+constexpr int MAX_DEVICE_MENU_ITEMS = 16;
+
+// How often the device state is updated. While the window is minimized nothing is drawn, and the device state is
+// updated just often enough to keep up with the sensor values of the pad.
+constexpr int UPDATE_INTERVAL_MS = 10;
+constexpr int MINIMIZED_UPDATE_INTERVAL_MS = 50;
 
 
 // ====================================================================================================================
@@ -57,8 +69,15 @@ public:
 
         fileMenu->Append(PROFILE_LOAD, wxT("Load profile"));
         fileMenu->Append(PROFILE_SAVE, wxT("Save profile"));
+        fileMenu->AppendSeparator();
+        myRecordItem = fileMenu->Append(CAPTURE_RECORD, wxT("Record sensor capture"));
+        fileMenu->Append(CAPTURE_REPLAY, wxT("Replay sensor capture"));
+        fileMenu->AppendSeparator();
         fileMenu->Append(MENU_EXIT, wxT("Exit"));
 
+        myDeviceMenu = new wxMenu();
+        menuBar->Append(myDeviceMenu, wxT("Device"));
+
         SetMenuBar(menuBar);
 
         auto sizer = new wxBoxSizer(wxVERTICAL);
@@ -69,8 +88,10 @@ public:
         SetSizer(sizer);
         UpdatePages();
 
+        myTabs->Bind(wxEVT_NOTEBOOK_PAGE_CHANGED, &MainWindow::OnPageChanged, this);
+
         myUpdateTimer = make_unique<UpdateTimer>(this);
-        myUpdateTimer->Start(10);
+        myUpdateTimer->Start(UPDATE_INTERVAL_MS);
     }
 
     ~MainWindow()
@@ -94,7 +115,7 @@ public:
 		fileStream.open((std::string)dlg.GetPath());
 		if(!fileStream.is_open())
 		{
-			Log::Writef(L"Could not read profile: %ls", dlg.GetPath());
+			Log::Writef(L"Could not read profile: %ls", dlg.GetPath().wc_str());
             return;
         }
 
@@ -132,7 +153,7 @@ public:
         wxFileOutputStream output_stream(dlg.GetPath());
         if (!output_stream.IsOk())
         {
-			Log::Writef(L"Could not save profile: %ls", dlg.GetPath());
+			Log::Writef(L"Could not save profile: %ls", dlg.GetPath().wc_str());
             return;
         }
 
@@ -151,6 +172,40 @@ public:
         }
     }
 
+    void CaptureRecord(wxCommandEvent& event)
+    {
+        if (Device::IsRecording())
+        {
+            Device::StopRecording();
+            myRecordItem->SetItemLabel(wxT("Record sensor capture"));
+            return;
+        }
+
+        if (!Device::Pad())
+            return;
+
+        wxFileDialog dlg(this, L"Record sensor capture", L"", L"capture", L"ADP capture (*.adpcap)|*.adpcap|All files (*)|*",
+            wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+
+        if (dlg.ShowModal() == wxID_CANCEL)
+            return;
+
+        if (Device::StartRecording((std::string)dlg.GetPath()))
+            myRecordItem->SetItemLabel(wxT("Stop recording"));
+    }
+
+    void CaptureReplay(wxCommandEvent& event)
+    {
+        wxFileDialog dlg(this, L"Replay sensor capture", L"", L"", L"ADP capture (*.adpcap)|*.adpcap|All files (*)|*",
+            wxFD_OPEN | wxFD_FILE_MUST_EXIST);
+
+        if (dlg.ShowModal() == wxID_CANCEL)
+            return;
+
+        if (!Device::ReplayCapture((std::string)dlg.GetPath(), 1.0))
+            Log::Writef(L"Could not replay capture: %ls", dlg.GetPath().wc_str());
+    }
+
     void Tick()
     {
         auto changes = Device::Update();
@@ -165,7 +220,14 @@ public:
         }
 
         if (changes & (DCF_DEVICE | DCF_NAME))
+        {
             UpdateStatusText();
+            UpdateDeviceMenu();
+        }
+
+        // A recording ends when its device disconnects.
+        if ((changes & DCF_DEVICE) && !Device::IsRecording())
+            myRecordItem->SetItemLabel(wxT("Record sensor capture"));
 
         wstring debugMessage = Device::ReadDebug();
 
@@ -181,9 +243,35 @@ public:
                 tab->HandleChanges(changes);
         }
 
+        // Only the tab that is shown is ticked, at the rate it asks for.
         auto activeTab = GetActiveTab();
-        if (activeTab)
+        Device::SetSensorStream(activeTab && activeTab->ShowsSensorValues() && !IsIconized());
+        auto now = std::chrono::steady_clock::now();
+        if (activeTab && !IsIconized() && now >= myNextTabTick)
+        {
+            myNextTabTick = now + std::chrono::milliseconds(activeTab->TickInterval());
             activeTab->Tick();
+        }
+    }
+
+    void OnPageChanged(wxBookCtrlEvent& event)
+    {
+        // The tab that comes into view is ticked right away, instead of showing what it had when it was hidden.
+        myNextTabTick = {};
+        event.Skip();
+    }
+
+    void OnIconize(wxIconizeEvent& event)
+    {
+        myUpdateTimer->Start(event.IsIconized() ? MINIMIZED_UPDATE_INTERVAL_MS : UPDATE_INTERVAL_MS);
+        myNextTabTick = {};
+        event.Skip();
+    }
+
+    void SelectDevice(wxCommandEvent& event)
+    {
+        // Pages are rebuilt on the next tick, when the device change comes in.
+        Device::SelectDevice(event.GetId() - DEVICE_SELECT);
     }
 
     void CloseApp(wxCommandEvent & event)
@@ -219,10 +307,19 @@ private:
             AddTab(1, new GraphTab(myTabs, pad), GraphTab::Title, true);
             AddTab(2, new MappingTab(myTabs, pad), MappingTab::Title);
             AddTab(3, new DeviceTab(myTabs), DeviceTab::Title);
+            int index = 4;
             auto lights = Device::Lights();
             if (pad->featureLights && lights)
             {
-                AddTab(4, new LightsTab(myTabs, lights), LightsTab::Title);
+                AddTab(index++, new LightsTab(myTabs, lights), LightsTab::Title);
+            }
+            if (pad->firmwareVersion.IsNewer({ 1, 4 }))
+            {
+                AddTab(index++, new LatencyTab(myTabs), LatencyTab::Title);
+            }
+            if (pad->featureStats)
+            {
+                AddTab(index++, new DiagnosticsTab(myTabs), DiagnosticsTab::Title);
             }
         }
         else
@@ -234,16 +331,37 @@ private:
     void UpdateStatusText()
     {
         auto pad = Device::Pad();
-        if (pad)
+        if (pad && Device::NumDevices() > 1)
+            SetStatusText(wxString::Format(L"Connected to: %s (%i of %i)", pad->name, Device::SelectedDevice() + 1, Device::NumDevices()), 0);
+        else if (pad)
             SetStatusText(L"Connected to: " + pad->name, 0);
         else
             SetStatusText(wxEmptyString, 0);
     }
 
+    void UpdateDeviceMenu()
+    {
+        while (myDeviceMenu->GetMenuItemCount() > 0)
+            myDeviceMenu->Destroy(myDeviceMenu->FindItemByPosition(0));
+
+        int numDevices = min(Device::NumDevices(), MAX_DEVICE_MENU_ITEMS);
+        for (int i = 0; i < numDevices; ++i)
+        {
+            auto pad = Device::Pad(i);
+            myDeviceMenu->AppendRadioItem(DEVICE_SELECT + i, wxString::Format(L"%i: %s", i + 1, pad->name));
+        }
+
+        if (Device::SelectedDevice() < numDevices)
+            myDeviceMenu->Check(DEVICE_SELECT + Device::SelectedDevice(), true);
+    }
+
     void UpdatePollingRate()
     {
         auto rate = Device::PollingRate();
-        if (rate > 0)
+        auto pad = Device::Pad();
+        if (rate > 0 && pad && pad->reportRate > 0)
+            SetStatusText(wxString::Format("%iHz (pad: %iHz, %u missed)", rate, pad->reportRate, pad->missedFrames), 1);
+        else if (rate > 0)
             SetStatusText(wxString::Format("%iHz", rate), 1);
         else
             SetStatusText(wxEmptyString, 1);
@@ -276,15 +394,22 @@ private:
     wxString lastProfile = "";
     wxApp* myApp;
     wxNotebook* myTabs;
+    wxMenu* myDeviceMenu;
+    wxMenuItem* myRecordItem;
     vector<BaseTab*> myTabList;
     unique_ptr<wxTimer> myUpdateTimer;
+    std::chrono::steady_clock::time_point myNextTabTick;
 };
 
 BEGIN_EVENT_TABLE(MainWindow, wxFrame)
     EVT_CLOSE(MainWindow::OnClose)
+    EVT_ICONIZE(MainWindow::OnIconize)
     EVT_MENU(MENU_EXIT, MainWindow::CloseApp)
     EVT_MENU(PROFILE_LOAD, MainWindow::ProfileLoad)
     EVT_MENU(PROFILE_SAVE, MainWindow::ProfileSave)
+    EVT_MENU(CAPTURE_RECORD, MainWindow::CaptureRecord)
+    EVT_MENU(CAPTURE_REPLAY, MainWindow::CaptureReplay)
+    EVT_MENU_RANGE(DEVICE_SELECT, DEVICE_SELECT + MAX_DEVICE_MENU_ITEMS - 1, MainWindow::SelectDevice)
 END_EVENT_TABLE()
 
 // ====================================================================================================================
@@ -323,6 +448,10 @@ bool Application::OnInit()
         return false;
 
     Log::Init();
+    if (logDebug)
+        Log::SetLevel(LOG_DEBUG);
+    if (!logPath.empty() && !Log::SetFile(logPath.ToStdString().c_str()))
+        Log::Writef(L"Could not open log file: %ls", logPath.wc_str());
 
     auto versionString = wstring(TOOL_NAME) + L" " +
         to_wstring(ADP_VERSION_MAJOR) + L"." + to_wstring(ADP_VERSION_MINOR);
@@ -334,6 +463,13 @@ bool Application::OnInit()
     Assets::Init();
     Device::Init();
 
+    if (emulatorReportRate > 0)
+    {
+        EmulatorSettings settings;
+        settings.reportRate = (int)emulatorReportRate;
+        Device::ConnectEmulator(settings);
+    }
+
     wxImage::AddHandler(new wxPNGHandler());
 
     wxIconBundle icons;
@@ -360,6 +496,25 @@ bool Application::OnInit()
     return true;
 }
 
+void Application::OnInitCmdLine(wxCmdLineParser& parser)
+{
+    wxApp::OnInitCmdLine(parser);
+
+    // Lets the tool run without a pad, for example to test the views.
+    parser.AddLongOption("emulate", "connect a simulated pad reporting at the given rate (1000-8000 hz)", wxCMD_LINE_VAL_NUMBER);
+
+    parser.AddLongOption("log-file", "also write the log to the given file");
+    parser.AddLongSwitch("log-debug", "include debug messages in the log, like every report transfer");
+}
+
+bool Application::OnCmdLineParsed(wxCmdLineParser& parser)
+{
+    parser.Found("emulate", &emulatorReportRate);
+    parser.Found("log-file", &logPath);
+    logDebug = parser.Found("log-debug");
+    return wxApp::OnCmdLineParsed(parser);
+}
+
 void Application::Restart()
 {
     doRestart = true;
@@ -2,6 +2,7 @@
 
 #include "wx/wx.h"
 #include "wx/notebook.h"
+#include "wx/cmdline.h"
 
 namespace adp {
 	
@@ -16,6 +17,10 @@ public:
 
     bool OnInit() override;
 
+    void OnInitCmdLine(wxCmdLineParser& parser) override;
+
+    bool OnCmdLineParsed(wxCmdLineParser& parser) override;
+
     void Restart();
 
     int OnExit() override;
@@ -26,6 +31,9 @@ public:
 private:
     MainWindow* myWindow;
     bool doRestart = false;
+    long emulatorReportRate = 0;
+    wxString logPath;
+    bool logDebug = false;
 };
 
 }; // namespace adp.
@@ -0,0 +1,46 @@
+#include "Adp.h"
+
+#include "Model/Board.h"
+
+namespace adp {
+
+BoardType ParseBoardType(const std::string& str)
+{
+	if (str == "fsrio1") { return BOARD_FSRIO_V1; }
+	if (str == "fsrminipad") { return BOARD_FSRMINIPAD; }
+	if (str == "teensy2") { return BOARD_TEENSY2; }
+	if (str == "leonardo") { return BOARD_LEONARDO; }
+	else { return BOARD_UNKNOWN; }
+}
+
+const wchar_t* BoardTypeToString(BoardType boardType, bool firmwareFile)
+{
+	if (boardType == BOARD_FSRIO_V1) {
+		return firmwareFile ? L"FSRioV1" : L"FSRio V1";
+	}
+
+	if (boardType == BOARD_FSRMINIPAD) {
+		return firmwareFile ? L"FSRMiniPad" : L"FSR Mini pad";
+	}
+
+	if (boardType == BOARD_FSRMINIPAD_V2) {
+		return firmwareFile ? L"FSRMiniPadV2" : L"FSR Mini pad V2";
+	}
+
+	if (boardType == BOARD_TEENSY2) {
+		return firmwareFile ? L"Teensy2" : L"Teensy 2";
+	}
+
+	if (boardType == BOARD_LEONARDO) {
+		return firmwareFile ? L"Generic" : L"Arduino leonardo/pro micro";
+	}
+
+	return L"Unknown";
+}
+
+const wchar_t* BoardTypeToString(BoardType boardType)
+{
+	return BoardTypeToString(boardType, false);
+}
+
+}; // namespace adp.
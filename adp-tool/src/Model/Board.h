@@ -0,0 +1,43 @@
+#pragma once
+
+#include "stdint.h"
+#include <string>
+
+using namespace std;
+
+namespace adp {
+
+enum BoardType {
+	BOARD_UNKNOWN,
+	BOARD_FSRMINIPAD,
+	BOARD_FSRMINIPAD_V2,
+	BOARD_TEENSY2,
+	BOARD_LEONARDO,
+	BOARD_FSRIO_V1
+};
+
+struct VersionType {
+	uint16_t major;
+	uint16_t minor;
+
+	bool IsNewer(VersionType then) const
+	{
+		if (major > then.major) {
+			return true;
+		}
+
+		if (major == then.major && minor > then.minor) {
+			return true;
+		}
+
+		return false;
+	}
+};
+
+static const VersionType versionTypeUnknown = { 0, 0 };
+
+enum BoardType ParseBoardType(const std::string& str);
+const wchar_t* BoardTypeToString(BoardType boardType);
+const wchar_t* BoardTypeToString(BoardType boardType, bool firmwareFile);
+
+}; // namespace adp.
@@ -0,0 +1,296 @@
+#include "Adp.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#include "Model/Capture.h"
+#include "Model/Log.h"
+
+using namespace std;
+using namespace chrono;
+
+namespace adp {
+
+static const char CAPTURE_MAGIC[6] = { 'A', 'D', 'P', 'C', 'A', 'P' };
+constexpr uint8_t CAPTURE_VERSION = 1;
+
+// Frames are collected in memory and written in blocks of about this size.
+constexpr size_t CAPTURE_WRITE_BLOCK_SIZE = 16 * 1024;
+
+// If a replay falls behind by more than this, it continues from the current time instead of catching up.
+constexpr auto MAX_REPLAY_LAG = milliseconds(100);
+
+// ====================================================================================================================
+// Helper functions.
+// ====================================================================================================================
+
+static void PutVarint(vector<uint8_t>& out, uint32_t value)
+{
+	while (value >= 0x80)
+	{
+		out.push_back((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back((uint8_t)value);
+}
+
+static bool GetVarint(FILE* file, uint32_t& value)
+{
+	value = 0;
+	for (int shift = 0; shift < 35; shift += 7)
+	{
+		int byte = fgetc(file);
+		if (byte == EOF)
+			return false;
+
+		value |= (uint32_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+			return true;
+	}
+	return false;
+}
+
+// Maps small negative and positive differences to small unsigned numbers.
+static uint32_t ZigZagEncode(int32_t value) { return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31); }
+static int32_t ZigZagDecode(uint32_t value) { return (int32_t)(value >> 1) ^ -(int32_t)(value & 1); }
+
+template <typename T>
+static void PutStruct(vector<uint8_t>& out, const T& value)
+{
+	out.push_back((uint8_t)(sizeof(T) & 0xFF));
+	out.push_back((uint8_t)(sizeof(T) >> 8));
+	auto bytes = (const uint8_t*)&value;
+	out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+static bool GetStruct(FILE* file, T& value)
+{
+	uint8_t size[2];
+	if (fread(size, 1, 2, file) != 2 || (size[0] | (size[1] << 8)) != sizeof(T))
+		return false;
+
+	return fread(&value, 1, sizeof(T), file) == sizeof(T);
+}
+
+static int NumCaptureSensors(const CaptureHeader& header)
+{
+	return min((int)header.identification.sensorCount, MAX_SENSOR_COUNT);
+}
+
+// ====================================================================================================================
+// Capture writer.
+// ====================================================================================================================
+
+CaptureWriter::~CaptureWriter()
+{
+	Close();
+}
+
+bool CaptureWriter::Open(const char* path, const CaptureHeader& header)
+{
+	Close();
+
+	myFile = fopen(path, "wb");
+	if (!myFile)
+	{
+		Log::Writef(L"CaptureWriter :: could not open %hs", path);
+		return false;
+	}
+
+	myNumSensors = NumCaptureSensors(header);
+	myNumFrames = 0;
+	myPrevious = SensorValuesReport();
+
+	myBuffer.clear();
+	myBuffer.insert(myBuffer.end(), CAPTURE_MAGIC, CAPTURE_MAGIC + sizeof(CAPTURE_MAGIC));
+	myBuffer.push_back(CAPTURE_VERSION);
+	PutStruct(myBuffer, header.identification);
+	PutStruct(myBuffer, header.name);
+	PutStruct(myBuffer, header.configuration);
+	Flush();
+
+	Log::Writef(L"CaptureWriter :: recording to %hs", path);
+	return true;
+}
+
+void CaptureWriter::Write(steady_clock::time_point timestamp, const SensorValuesReport& report)
+{
+	if (!myFile)
+		return;
+
+	auto delay = (myNumFrames == 0) ? 0 : duration_cast<microseconds>(timestamp - myPreviousTime).count();
+	PutVarint(myBuffer, (uint32_t)clamp<long long>(delay, 0, UINT32_MAX));
+
+	// Buttons are stored as the bits that changed, sensors as the difference to the previous value.
+	PutVarint(myBuffer, ReadU16LE(report.buttonBits) ^ ReadU16LE(myPrevious.buttonBits));
+	for (int i = 0; i < myNumSensors; ++i)
+	{
+		int difference = (int)ReadU16LE(report.sensorValues[i]) - (int)ReadU16LE(myPrevious.sensorValues[i]);
+		PutVarint(myBuffer, ZigZagEncode(difference));
+	}
+
+	myPreviousTime = timestamp;
+	myPrevious = report;
+	++myNumFrames;
+
+	if (myBuffer.size() >= CAPTURE_WRITE_BLOCK_SIZE)
+		Flush();
+}
+
+void CaptureWriter::Close()
+{
+	if (!myFile)
+		return;
+
+	Flush();
+	fclose(myFile);
+	myFile = nullptr;
+
+	Log::Writef(L"CaptureWriter :: recording stopped, %i frames written", myNumFrames);
+}
+
+void CaptureWriter::Flush()
+{
+	if (myBuffer.empty())
+		return;
+
+	if (fwrite(myBuffer.data(), 1, myBuffer.size(), myFile) != myBuffer.size())
+		Log::Write(L"CaptureWriter :: write failed");
+
+	fflush(myFile);
+	myBuffer.clear();
+}
+
+// ====================================================================================================================
+// Capture reader.
+// ====================================================================================================================
+
+CaptureReader::~CaptureReader()
+{
+	if (myFile)
+		fclose(myFile);
+}
+
+bool CaptureReader::Open(const char* path)
+{
+	if (myFile)
+		fclose(myFile);
+
+	myFile = fopen(path, "rb");
+	if (!myFile)
+	{
+		Log::Writef(L"CaptureReader :: could not open %hs", path);
+		return false;
+	}
+
+	char magic[sizeof(CAPTURE_MAGIC)];
+	bool valid =
+		fread(magic, 1, sizeof(magic), myFile) == sizeof(magic) &&
+		memcmp(magic, CAPTURE_MAGIC, sizeof(magic)) == 0 &&
+		fgetc(myFile) == CAPTURE_VERSION &&
+		GetStruct(myFile, myHeader.identification) &&
+		GetStruct(myFile, myHeader.name) &&
+		GetStruct(myFile, myHeader.configuration);
+
+	if (!valid)
+	{
+		Log::Writef(L"CaptureReader :: %hs is not a valid capture file", path);
+		fclose(myFile);
+		myFile = nullptr;
+		return false;
+	}
+
+	myFramesStart = ftell(myFile);
+	Rewind();
+	return true;
+}
+
+bool CaptureReader::Next(microseconds& delay, SensorValuesReport& report)
+{
+	if (!myFile)
+		return false;
+
+	report = myPrevious;
+
+	uint32_t value;
+	if (!GetVarint(myFile, value))
+		return false;
+	delay = microseconds(value);
+
+	if (!GetVarint(myFile, value))
+		return false;
+	report.buttonBits = WriteU16LE((uint16_t)(ReadU16LE(myPrevious.buttonBits) ^ value));
+
+	for (int i = 0; i < NumCaptureSensors(myHeader); ++i)
+	{
+		if (!GetVarint(myFile, value))
+			return false;
+		report.sensorValues[i] = WriteU16LE((uint16_t)(ReadU16LE(myPrevious.sensorValues[i]) + ZigZagDecode(value)));
+	}
+
+	myPrevious = report;
+	return true;
+}
+
+void CaptureReader::Rewind()
+{
+	if (!myFile)
+		return;
+
+	fseek(myFile, myFramesStart, SEEK_SET);
+	myPrevious = SensorValuesReport();
+}
+
+// ====================================================================================================================
+// Capture replay.
+// ====================================================================================================================
+
+CaptureReplay::CaptureReplay(double speed)
+	: mySpeed(speed > 0 ? speed : 1.0)
+{
+}
+
+ReadDataResult CaptureReplay::Read(SensorValuesReport& report, int timeoutMs)
+{
+	auto now = steady_clock::now();
+
+	if (!myHasFrame)
+	{
+		microseconds delay;
+		if (!myReader.Next(delay, myFrame))
+		{
+			myReader.Rewind();
+			if (!myReader.Next(delay, myFrame))
+				return ReadDataResult::FAILURE;
+		}
+
+		if (myFrameTime < now - MAX_REPLAY_LAG)
+			myFrameTime = now;
+
+		myFrameTime += duration_cast<steady_clock::duration>(delay / mySpeed);
+		myHasFrame = true;
+	}
+
+	// Like a device, wait for the next report up to the timeout. A negative timeout waits until it is there.
+	if (myFrameTime > now)
+	{
+		if (timeoutMs == 0)
+			return ReadDataResult::NO_DATA;
+
+		auto wakeup = myFrameTime;
+		if (timeoutMs > 0)
+			wakeup = min(wakeup, now + milliseconds(timeoutMs));
+
+		this_thread::sleep_until(wakeup);
+		if (myFrameTime > steady_clock::now())
+			return ReadDataResult::NO_DATA;
+	}
+
+	report = myFrame;
+	myHasFrame = false;
+	return ReadDataResult::SUCCESS;
+}
+
+}; // namespace adp.
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "Model/Reporter.h"
+
+namespace adp {
+
+// Describes the pad a capture was recorded from, so a replay can present itself as that pad.
+struct CaptureHeader
+{
+	IdentificationV2Report identification;
+	NameReport name;
+	PadConfigurationReport configuration;
+};
+
+// Writes raw sensor value reports to a capture file. The file starts with the header, followed by one frame per
+// report. A frame stores the time since the previous frame, and the button and sensor values relative to the previous
+// frame, as varints. Most values barely change between reports, so a frame usually takes a few bytes per sensor.
+// Frames are only ever appended, a capture that was cut off can be read up to the last complete frame.
+class CaptureWriter
+{
+public:
+	~CaptureWriter();
+
+	bool Open(const char* path, const CaptureHeader& header);
+	void Write(std::chrono::steady_clock::time_point timestamp, const SensorValuesReport& report);
+	void Close();
+
+	bool IsOpen() const { return myFile != nullptr; }
+	int NumFrames() const { return myNumFrames; }
+
+private:
+	void Flush();
+
+	FILE* myFile = nullptr;
+	int myNumSensors = 0;
+	int myNumFrames = 0;
+	std::chrono::steady_clock::time_point myPreviousTime;
+	SensorValuesReport myPrevious;
+	std::vector<uint8_t> myBuffer;
+};
+
+// Reads the frames of a capture file in order.
+class CaptureReader
+{
+public:
+	~CaptureReader();
+
+	bool Open(const char* path);
+	const CaptureHeader& Header() const { return myHeader; }
+
+	// Reads the next frame. The delay is the time that passed between the previous report and this one.
+	// Returns false at the end of the capture.
+	bool Next(std::chrono::microseconds& delay, SensorValuesReport& report);
+
+	// Starts reading from the first frame again.
+	void Rewind();
+
+private:
+	FILE* myFile = nullptr;
+	long myFramesStart = 0;
+	CaptureHeader myHeader;
+	SensorValuesReport myPrevious;
+};
+
+// Hands out the frames of a capture as sensor value reports, spaced like they were recorded. With a speed above one
+// the capture plays faster. When the end is reached, the capture starts over.
+class CaptureReplay
+{
+public:
+	CaptureReplay(double speed);
+
+	bool Open(const char* path) { return myReader.Open(path); }
+	const CaptureHeader& Header() const { return myReader.Header(); }
+
+	// Behaves like reading from a device, see Reporter::Get.
+	ReadDataResult Read(SensorValuesReport& report, int timeoutMs);
+
+private:
+	CaptureReader myReader;
+	double mySpeed;
+	bool myHasFrame = false;
+	SensorValuesReport myFrame;
+	std::chrono::steady_clock::time_point myFrameTime;
+};
+
+}; // namespace adp.
@@ -0,0 +1,100 @@
+#include "Adp.h"
+
+#include <algorithm>
+
+#include "Model/CommandQueue.h"
+
+using namespace std;
+
+namespace adp {
+
+CommandQueue::CommandQueue()
+{
+	myWorker = thread(&CommandQueue::Run, this);
+}
+
+CommandQueue::~CommandQueue()
+{
+	// Commands that are still queued are executed before the worker stops.
+	{
+		lock_guard<mutex> lock(myMutex);
+		myIsStopping = true;
+	}
+	myWakeup.notify_one();
+
+	if (myWorker.joinable())
+		myWorker.join();
+}
+
+shared_future<bool> CommandQueue::Push(uint32_t key, Command command, Callback callback)
+{
+	lock_guard<mutex> lock(myMutex);
+
+	Entry entry;
+	entry.key = key;
+	entry.command = move(command);
+
+	// There is at most one queued command per key, it takes over the waiters of the one it replaces.
+	if (key != NO_KEY)
+	{
+		auto it = find_if(myEntries.begin(), myEntries.end(), [key](const Entry& queued) { return queued.key == key; });
+		if (it != myEntries.end())
+		{
+			entry.callbacks = move(it->callbacks);
+			entry.promise = move(it->promise);
+			entry.future = move(it->future);
+			myEntries.erase(it);
+		}
+	}
+
+	if (!entry.promise)
+	{
+		entry.promise = make_shared<promise<bool>>();
+		entry.future = entry.promise->get_future().share();
+	}
+
+	if (callback)
+		entry.callbacks.push_back(move(callback));
+
+	auto future = entry.future;
+	myEntries.push_back(move(entry));
+	myWakeup.notify_one();
+	return future;
+}
+
+void CommandQueue::Flush()
+{
+	unique_lock<mutex> lock(myMutex);
+	myIdle.wait(lock, [this] { return myEntries.empty() && !myIsBusy; });
+}
+
+void CommandQueue::Run()
+{
+	unique_lock<mutex> lock(myMutex);
+	while (true)
+	{
+		myWakeup.wait(lock, [this] { return !myEntries.empty() || myIsStopping; });
+
+		if (myEntries.empty())
+			break;
+
+		auto entry = move(myEntries.front());
+		myEntries.pop_front();
+		myIsBusy = true;
+
+		lock.unlock();
+
+		bool result = entry.command();
+		for (auto& callback : entry.callbacks)
+			callback(result);
+		entry.promise->set_value(result);
+
+		lock.lock();
+		myIsBusy = false;
+
+		if (myEntries.empty())
+			myIdle.notify_all();
+	}
+}
+
+}; // namespace adp.
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+namespace adp {
+
+// Runs device transfers on a worker thread, so the thread that makes a change never waits for USB.
+// Commands are executed in the order they were pushed. A command pushed with a key removes a queued command with the
+// same key that has not started yet, so only the latest write to a report is sent. The new command goes to the end of
+// the queue, it never runs ahead of commands that were pushed after the one it replaced. The replaced command's future
+// and callbacks receive the result of the command that replaced it.
+class CommandQueue
+{
+public:
+	typedef std::function<bool()> Command;
+	typedef std::function<void(bool)> Callback;
+
+	// Key for commands that are never replaced.
+	static constexpr uint32_t NO_KEY = 0;
+
+	// Identifies a write to one report, for example the sensor report of one sensor.
+	static constexpr uint32_t Key(uint8_t reportId, int index = 0) { return ((uint32_t)reportId << 16) | (uint32_t)(index + 1); }
+
+	CommandQueue();
+	~CommandQueue();
+
+	// Callbacks run on the worker thread.
+	std::shared_future<bool> Push(uint32_t key, Command command, Callback callback = nullptr);
+
+	// Blocks until every command pushed so far has been executed.
+	void Flush();
+
+private:
+	struct Entry
+	{
+		uint32_t key;
+		Command command;
+		std::vector<Callback> callbacks;
+		std::shared_ptr<std::promise<bool>> promise;
+		std::shared_future<bool> future;
+	};
+
+	void Run();
+
+	std::deque<Entry> myEntries;
+	std::mutex myMutex;
+	std::condition_variable myWakeup;
+	std::condition_variable myIdle;
+	bool myIsBusy = false;
+	bool myIsStopping = false;
+	std::thread myWorker;
+};
+
+}; // namespace adp.
@@ -5,15 +5,25 @@
 #include <map>
 #include <chrono>
 #include <thread>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <cstddef>
+#include <cstdio>
 
 #include "hidapi.h"
 
 #include "Model/Device.h"
 #include "Model/Reporter.h"
+#include "Model/Capture.h"
+#include "Model/Emulator.h"
+#include "Model/CommandQueue.h"
+#include "Model/Hotplug.h"
+#include "Model/LatencyStats.h"
+#include "Model/RingBuffer.h"
+#include "Model/SampleHistory.h"
 #include "Model/Log.h"
 #include "Model/Utils.h"
-#include "Model/Firmware.h"
-#include "Model/Updater.h"
 
 using namespace std;
 using namespace chrono;
@@ -33,8 +43,6 @@ constexpr HidIdentifier HID_IDS[] =
 	{0x03eb, 0x204f},
 };
 
-static_assert(sizeof(float) == sizeof(uint32_t), "32-bit float required");
-
 enum LedMappingFlags
 {
 	LMF_ENABLED = 1 << 0,
@@ -56,44 +64,14 @@ static bool IsBitSet(int bits, int index)
 	return (bits & (1 << index)) != 0;
 }
 
-static int ReadU16LE(uint16_le u16)
-{
-	return u16.bytes[0] | u16.bytes[1] << 8;
-}
-
-static uint32_t ReadU32LE(uint32_le u32)
-{
-	return u32.bytes[0] | (u32.bytes[1] << 8) | (u32.bytes[2] << 16) | (u32.bytes[3] << 24);
-}
-
-static float ReadF32LE(float32_le f32)
+static bool IsCompatibleDevice(int vendorId, int productId)
 {
-	uint32_t u32 = ReadU32LE(f32.bits);
-	return *reinterpret_cast<float*>(&u32);
-}
-
-static uint16_le WriteU16LE(int value)
-{
-	uint16_le u16;
-	u16.bytes[0] = value & 0xFF;
-	u16.bytes[1] = (value >> 8) & 0xFF;
-	return u16;
-}
-
-static uint32_le WriteU32LE(uint32_t value)
-{
-	uint32_le u32;
-	u32.bytes[0] = value & 0xFF;
-	u32.bytes[1] = (value >> 8) & 0xFF;
-	u32.bytes[2] = (value >> 16) & 0xFF;
-	u32.bytes[3] = (value >> 24) & 0xFF;
-	return u32;
-}
-
-static float32_le WriteF32LE(float value)
-{
-	uint32_t u32 = *reinterpret_cast<uint32_t*>(&value);
-	return { WriteU32LE(u32) };
+	for (auto id : HID_IDS)
+	{
+		if (vendorId == id.vendorId && productId == id.productId)
+			return true;
+	}
+	return false;
 }
 
 template <typename T>
@@ -128,10 +106,32 @@ SensorReport SensorState::ToReport(int index)
 	report.releaseThreshold = WriteU16LE(ToDeviceSensorValue(releaseThreshold));
 	report.resistorValue = resistorValue;
 	report.buttonMapping = button == 0 ? 0xFF : (button - 1);
+	report.flags = WriteU16LE(otherFlags |
+		(medianFilter ? SensorReport::ADC_MEDIAN_FILTER : 0) |
+		((oversampleShift << SensorReport::OVERSAMPLE_SHIFT_OFFSET) & SensorReport::OVERSAMPLE_SHIFT_MASK));
 
 	return report;
 }
 
+RgbColor::RgbColor(std::string input)
+	:red(0), green(0), blue(0)
+{
+	unsigned int r, g, b;
+	if (input.size() == 7 && sscanf(input.c_str(), "#%02x%02x%02x", &r, &g, &b) == 3)
+	{
+		red = (uint8_t)r;
+		green = (uint8_t)g;
+		blue = (uint8_t)b;
+	}
+}
+
+const std::string RgbColor::ToString() const
+{
+	char buffer[8];
+	snprintf(buffer, sizeof(buffer), "#%02X%02X%02X", red, green, blue);
+	return buffer;
+}
+
 static void PrintPadConfigurationReport(const PadConfigurationReport& padConfiguration)
 {
 	Log::Write(L"pad configuration [");
@@ -196,6 +196,27 @@ struct PollingData
 	time_point<system_clock> lastUpdate;
 };
 
+// A raw sensor values report, stamped with the time the reader thread received it.
+struct SensorSample
+{
+	time_point<steady_clock> timestamp;
+	SensorValuesReport report;
+	InputTiming timing;
+	bool buttonsOnly;
+};
+
+// Roughly one second of reports at a 1 kHz polling rate.
+constexpr size_t SENSOR_SAMPLE_BUFFER_SIZE = 1024;
+
+// Until the polling rate is known, the sensor history assumes this many reports per second.
+constexpr int DEFAULT_HISTORY_RATE = 1000;
+
+// How long the reader thread blocks on a read before checking if it should stop.
+constexpr int SENSOR_READ_TIMEOUT_MS = 100;
+
+// How often the debug report is read. While the pad has more text waiting, it is read on every update.
+constexpr auto DEBUG_POLL_INTERVAL = milliseconds(100);
+
 class PadDevice
 {
 public:
@@ -206,9 +227,12 @@ public:
 		const IdentificationV2Report& identification,
 		const vector<LightRuleReport>& lightRules,
 		const vector<LedMappingReport>& ledMappings,
-		const vector<SensorReport>& sensors)
+		const vector<SensorReport>& sensors,
+		const vector<uint8_t>& configBlock)
 		: myReporter(move(reporter))
 		, myPath(path)
+		, myIdentification(identification)
+		, myConfigBlock(configBlock)
 	{
 		UpdateName(name);
 		myPad.maxNameLength = MAX_NAME_LENGTH;
@@ -229,8 +253,11 @@ public:
 
 		uint16_t features = ReadU16LE(identification.features);
 		myPad.featureDebug = (features & IdentificationV2Report::FEATURE_DEBUG) != 0;
+		myPad.featureDebugStream = (features & IdentificationV2Report::FEATURE_DEBUG_STREAM) != 0;
 		myPad.featureDigipot = (features & IdentificationV2Report::FEATURE_DIGIPOT) != 0;
 		myPad.featureLights = (features & IdentificationV2Report::FEATURE_LIGHTS) != 0;
+		myPad.featureFiltering = (features & IdentificationV2Report::FEATURE_FILTERING) != 0;
+		myPad.featureStats = (features & IdentificationV2Report::FEATURE_STATS) != 0;
 
 		for (auto sensor : sensors)
 		{
@@ -246,11 +273,144 @@ public:
 
 		UpdateLightsConfiguration(lightRules, ledMappings);
 		myPollingData.lastUpdate = system_clock::now();
+		myHistory.Reset(min(myPad.numSensors, MAX_SENSOR_COUNT));
+
+		// Newer firmware only sends sensor values when asked to, see UpdateAnalogStream.
+		SetDebugStream(true);
+
+		myIsReading = true;
+		myReaderThread = thread(&PadDevice::ReadSensorValues, this);
 	}
 
 	~PadDevice()
 	{
+		// The reader thread uses the reporter, so it has to be stopped before the reporter is destroyed.
+		myIsReading = false;
+		if (myReaderThread.joinable())
+			myReaderThread.join();
+
+		// Let the pad go back to compact reports. This fails silently if the pad is already gone.
+		SetDebugStream(false);
+		SetInputTiming(false);
+		SetAnalogStream(false);
+		myCommands.Flush();
+	}
+
+	void SetAnalogStream(bool enabled)
+	{
+		if (!myPad.firmwareVersion.IsNewer({ 1, 3 }))
+			return;
 
+		SetPropertyReport report;
+		report.propertyId = WriteU32LE(SetPropertyReport::ANALOG_STREAM);
+		report.propertyValue = WriteU32LE(enabled ? 1 : 0);
+		PushSend(CommandQueue::Key(REPORT_SET_PROPERTY, SetPropertyReport::ANALOG_STREAM), report);
+	}
+
+	// Debug builds of newer firmware send their debug text as input reports while this is on, instead of waiting for
+	// the debug report to be polled.
+	void SetDebugStream(bool enabled)
+	{
+		if (!myPad.featureDebugStream)
+			return;
+
+		SetPropertyReport report;
+		report.propertyId = WriteU32LE(SetPropertyReport::DEBUG_STREAM);
+		report.propertyValue = WriteU32LE(enabled ? 1 : 0);
+		PushSend(CommandQueue::Key(REPORT_SET_PROPERTY, SetPropertyReport::DEBUG_STREAM), report);
+	}
+
+	// Newer firmware sends compact button-only reports until asked for sensor values, so games get their input from
+	// the pad while the tool is connected. The stream is on while sensor values are shown, recorded or timed.
+	void UpdateAnalogStream()
+	{
+		bool enabled = myIsSensorStreamRequested || myRecorder.IsOpen() || myIsTimingInput;
+		if (enabled == myIsAnalogStream)
+			return;
+
+		myIsAnalogStream = enabled;
+		SetAnalogStream(enabled);
+	}
+
+	void SetSensorStream(bool enabled)
+	{
+		myIsSensorStreamRequested = enabled;
+		UpdateAnalogStream();
+	}
+
+	// Timed reports replace the sensor values reports, so this turns the analog stream on as well. Measurements are
+	// kept after disabling, until the next measurement starts.
+	bool SetInputTiming(bool enabled)
+	{
+		if (!myPad.firmwareVersion.IsNewer({ 1, 4 }))
+			return false;
+
+		SetPropertyReport report;
+		report.propertyId = WriteU32LE(SetPropertyReport::INPUT_TIMING);
+		report.propertyValue = WriteU32LE(enabled ? 1 : 0);
+		PushSend(CommandQueue::Key(REPORT_SET_PROPERTY, SetPropertyReport::INPUT_TIMING), report);
+
+		if (enabled && !myIsTimingInput)
+			myLatency.Reset();
+
+		myIsTimingInput = enabled;
+		UpdateAnalogStream();
+		return true;
+	}
+
+	bool IsTimingInput() const { return myIsTimingInput; }
+
+	bool HasLatency() const { return !myLatency.IsEmpty(); }
+
+	LatencySummary Latency() const { return myLatency.Summarize(); }
+
+	void ResetLatency() { myLatency.Reset(); }
+
+	bool Stats(PadStats& stats)
+	{
+		lock_guard<mutex> lock(myStatsMutex);
+		stats = myStats;
+		return myHasStats;
+	}
+
+	void ResetStats()
+	{
+		if (!myPad.featureStats)
+			return;
+
+		SetPropertyReport report;
+		report.propertyId = WriteU32LE(SetPropertyReport::RESET_STATS);
+		report.propertyValue = WriteU32LE(0);
+		PushSend(CommandQueue::Key(REPORT_SET_PROPERTY, SetPropertyReport::RESET_STATS), report);
+	}
+
+	// All transfers other than reading sensor values go through the command queue, so the GUI thread never waits for
+	// USB. Local state is updated right away, assuming the transfer will succeed.
+	template <typename T>
+	void PushSend(uint32_t key, const T& report)
+	{
+		auto reporter = myReporter.get();
+		PushWrite(key, [reporter, report]() { return reporter->Send(report); });
+	}
+
+	template <typename T>
+	void PushSendAndGet(uint32_t key, T report)
+	{
+		auto reporter = myReporter.get();
+		PushWrite(key, [reporter, report]() mutable { return reporter->SendAndGet(report); });
+	}
+
+	// Writes that fail are remembered until the next flush, so the caller learns that local state and the pad differ.
+	void PushWrite(uint32_t key, CommandQueue::Command command)
+	{
+		myCommands.Push(key, move(command), [this](bool succeeded) { if (!succeeded) myHasFailedWrites = true; });
+	}
+
+	// Blocks until all queued transfers are done. Returns false if a write failed since the previous flush.
+	bool FlushCommands()
+	{
+		myCommands.Flush();
+		return !myHasFailedWrites.exchange(false);
 	}
 
 	void UpdateName(const NameReport& report)
@@ -311,42 +471,85 @@ public:
 			UpdateLedMapping(report);
 	}
 
-	bool UpdateSensorValues()
+	// Runs on the reader thread. Blocks on the device and hands every report to the GUI thread through the sample
+	// buffer, so no report is lost when the GUI thread is busy.
+	void ReadSensorValues()
 	{
-		SensorValuesReport report;
+		SensorSample sample;
+		string debugText;
 
-		int aggregateValues[MAX_SENSOR_COUNT] = {};
-		int pressedButtons = 0;
-		int inputsRead = 0;
-
-		for (int readsLeft = 100; readsLeft > 0; --readsLeft)
+		while (myIsReading)
 		{
-			switch (myReporter->Get(report))
+			auto result = myReporter->Get(sample.report, sample.timing, debugText, SENSOR_READ_TIMEOUT_MS);
+			if (!debugText.empty())
+			{
+				lock_guard<mutex> lock(myDebugMutex);
+				myDebugText += widen(debugText.data(), debugText.size());
+				debugText.clear();
+			}
+
+			switch (result)
 			{
 			case ReadDataResult::SUCCESS:
-				pressedButtons |= ReadU16LE(report.buttonBits);
-				for (int i = 0; i < myPad.numSensors; ++i)
-					aggregateValues[i] += ReadU16LE(report.sensorValues[i]);
-				++inputsRead;
+			case ReadDataResult::BUTTONS_ONLY:
+				sample.buttonsOnly = (result == ReadDataResult::BUTTONS_ONLY);
+				sample.timestamp = steady_clock::now();
+				if (!mySamples.Push(sample))
+					++myDroppedSamples;
 				break;
 
 			case ReadDataResult::NO_DATA:
-				readsLeft = 0;
 				break;
 
 			case ReadDataResult::FAILURE:
-				return false;
+				myReadFailed = true;
+				return;
 			}
 		}
+	}
+
+	bool UpdateSensorValues()
+	{
+		if (myReadFailed)
+			return false;
+
+		SensorSample sample;
+
+		int aggregateValues[MAX_SENSOR_COUNT] = {};
+		int pressedButtons = 0;
+		int inputsRead = 0;
+		int sensorValuesRead = 0;
+
+		while (mySamples.Pop(sample))
+		{
+			pressedButtons |= ReadU16LE(sample.report.buttonBits);
+			++inputsRead;
+
+			// Compact reports only carry the buttons.
+			if (sample.buttonsOnly)
+				continue;
+
+			if (myRecorder.IsOpen())
+				myRecorder.Write(sample.timestamp, sample.report);
+
+			if (myIsTimingInput)
+				myLatency.Add(sample.timestamp, sample.report, sample.timing);
+
+			myHistory.Add(sample.report);
+
+			for (int i = 0; i < myPad.numSensors; ++i)
+				aggregateValues[i] += ReadU16LE(sample.report.sensorValues[i]);
+			++sensorValuesRead;
+		}
 
 		if (inputsRead > 0)
 		{
 			for (int i = 0; i < myPad.numSensors; ++i)
 			{
 				auto button = mySensors[i].button;
-				auto value = (double)aggregateValues[i] / (double)inputsRead;
 				mySensors[i].pressed = button > 0 && IsBitSet(pressedButtons, button - 1);
-				mySensors[i].value = ToNormalizedSensorValue(value);
+				if (sensorValuesRead > 0)
+					mySensors[i].value = ToNormalizedSensorValue((double)aggregateValues[i] / (double)sensorValuesRead);
 			}
 			myPollingData.readsSinceLastUpdate += inputsRead;
 		}
@@ -358,8 +561,17 @@ public:
 			myPollingData.pollingRate = (int)lround(myPollingData.readsSinceLastUpdate / dt);
 			myPollingData.readsSinceLastUpdate = 0;
 			myPollingData.lastUpdate = now;
+
+			int droppedSamples = myDroppedSamples.exchange(0);
+			if (droppedSamples > 0)
+				Log::Writef(L"PadDevice :: sample buffer full, %i reports dropped", droppedSamples);
+
+			UpdateReportStatistics();
 		}
 
+		myPad.reportRate = myReportRate;
+		myPad.missedFrames = myMissedFrames;
+
 		// Use the loop to save changes if needed
 		if (myHasUnsavedChanges && duration_cast<std::chrono::milliseconds>(now - myLastPendingChange).count() > 2000) {
 			SaveChanges();
@@ -368,6 +580,56 @@ public:
 		return true;
 	}
 
+	void UpdateReportStatistics()
+	{
+		if (!myPad.firmwareVersion.IsNewer({ 1, 3 }))
+			return;
+
+		auto reporter = myReporter.get();
+
+		// The stats report includes the report statistics, so pads that have it only need the one transfer.
+		if (myPad.featureStats)
+		{
+			myCommands.Push(CommandQueue::Key(REPORT_STATS), [this, reporter]()
+			{
+				StatsReport report;
+				if (!reporter->Get(report))
+					return false;
+
+				PadStats stats;
+				for (int i = 0; i < NUM_STATS_STAGES; ++i)
+				{
+					stats.stages[i].averageMicros = ReadU16LE(report.stages[i].averageMicros);
+					stats.stages[i].maxMicros = ReadU16LE(report.stages[i].maxMicros);
+					stats.stages[i].runsPerSecond = (int)ReadU32LE(report.stages[i].runsPerSecond);
+				}
+				stats.adcConversionsPerSecond = ReadU16LE(report.adcConversionsPerSecond);
+				stats.reportRate = ReadU16LE(report.reportRate);
+				stats.missedFrames = ReadU32LE(report.missedFrames);
+
+				myReportRate = stats.reportRate;
+				myMissedFrames = stats.missedFrames;
+
+				lock_guard<mutex> lock(myStatsMutex);
+				myStats = stats;
+				myHasStats = true;
+				return true;
+			});
+			return;
+		}
+
+		myCommands.Push(CommandQueue::Key(REPORT_IDENTIFICATION_V3), [this, reporter]()
+		{
+			IdentificationV3Report report;
+			if (!reporter->Get(report))
+				return false;
+
+			myReportRate = ReadU16LE(report.reportRate);
+			myMissedFrames = ReadU32LE(report.missedFrames);
+			return true;
+		});
+	}
+
 	bool SetThreshold(int sensorIndex, double threshold)
 	{
 		mySensors[sensorIndex].threshold = threshold;
@@ -388,14 +650,16 @@ public:
 
 		// From v1.3 we have the SensorReport. Before that it's the PadConfiguration report
 		if (myPad.firmwareVersion.IsNewer({ 1, 2 })) {
+			BeginBatch();
 			for (int i = 0; i < myPad.numSensors; ++i) {
 				mySensors[i].releaseThreshold = mySensors[i].threshold * myPad.releaseThreshold;
 				if (!SendSensor(i)) {
+					EndBatch();
 					return false;
 				}
 			}
 
-			return true;
+			return EndBatch();
 		}
 		else {
 			return SendPadConfiguration();
@@ -409,6 +673,14 @@ public:
 		return SendSensor(sensorIndex);
 	}
 
+	bool SetFilterConfig(int sensorIndex, int oversampleShift, bool medianFilter)
+	{
+		mySensors[sensorIndex].oversampleShift = clamp(oversampleShift, 0, SensorReport::MAX_OVERSAMPLE_SHIFT);
+		mySensors[sensorIndex].medianFilter = medianFilter;
+
+		return SendSensor(sensorIndex);
+	}
+
 	void UpdateSensor(SensorReport sensor)
 	{
 		if (sensor.index < 0 || sensor.index > myPad.numSensors) {
@@ -418,6 +690,11 @@ public:
 		mySensors[sensor.index].threshold = ToNormalizedSensorValue(ReadU16LE(sensor.threshold));
 		mySensors[sensor.index].releaseThreshold = ToNormalizedSensorValue(ReadU16LE(sensor.releaseThreshold));
 		mySensors[sensor.index].resistorValue = sensor.resistorValue;
+		uint16_t flags = ReadU16LE(sensor.flags);
+		int oversampleShift = (flags & SensorReport::OVERSAMPLE_SHIFT_MASK) >> SensorReport::OVERSAMPLE_SHIFT_OFFSET;
+		mySensors[sensor.index].oversampleShift = min(oversampleShift, SensorReport::MAX_OVERSAMPLE_SHIFT);
+		mySensors[sensor.index].medianFilter = (flags & SensorReport::ADC_MEDIAN_FILTER) != 0;
+		mySensors[sensor.index].otherFlags = flags & ~(SensorReport::OVERSAMPLE_SHIFT_MASK | SensorReport::ADC_MEDIAN_FILTER);
 		mySensors[sensor.index].button = (sensor.buttonMapping >= myPad.numButtons ? 0 : (sensor.buttonMapping + 1));
 	}
 
@@ -425,14 +702,15 @@ public:
 	{
 		SensorReport report = mySensors[sensorIndex].ToReport(sensorIndex);
 
-		bool success = myReporter->Send(report);
-
-		if (success) {
-			NotifyUnsavedChanges();
-			UpdateSensor(report);
-		}
+		if (IsBatching())
+			myPendingSensors.insert(sensorIndex);
+		else
+			PushSend(CommandQueue::Key(REPORT_SENSOR, sensorIndex), report);
 
-		return success;
+		StoreInConfigBlock(SensorBlockOffset(sensorIndex), &report.threshold, CONFIG_BLOCK_SENSOR_SIZE);
+		NotifyUnsavedChanges();
+		UpdateSensor(report);
+		return true;
 	}
 
 	bool SetButtonMapping(int sensorIndex, int button)
@@ -463,17 +741,20 @@ public:
 
 		report.size = (uint8_t)length;
 		memcpy(report.name, name, length);
-		bool result = myReporter->SendAndGet(report);
+		PushSendAndGet(CommandQueue::Key(REPORT_NAME), report);
 		NotifyUnsavedChanges();
 		UpdateName(report);
-		return result;
+		return true;
 	}
 
 	bool SendLedMappingReport(const LedMappingReport& report)
 	{
-		if (!myReporter->Send(report))
-			return false;
+		if (IsBatching())
+			myPendingLedMappings[report.ledMappingIndex] = report;
+		else
+			PushSend(CommandQueue::Key(REPORT_LED_MAPPING, report.ledMappingIndex), report);
 
+		StoreInConfigBlock(LedMappingBlockOffset(myPad.numSensors, report.ledMappingIndex), &report.flags, CONFIG_BLOCK_LED_MAPPING_SIZE);
 		UpdateLedMapping(report);
 
         // Only set when to update the tab
@@ -509,9 +790,12 @@ public:
 
 	bool SendLightRuleReport(const LightRuleReport& report)
 	{
-		if (!myReporter->Send(report))
-			return false;
+		if (IsBatching())
+			myPendingLightRules[report.lightRuleIndex] = report;
+		else
+			PushSend(CommandQueue::Key(REPORT_LIGHT_RULE, report.lightRuleIndex), report);
 
+		StoreInConfigBlock(LightRuleBlockOffset(myPad.numSensors, report.lightRuleIndex), &report.flags, CONFIG_BLOCK_LIGHT_RULE_SIZE);
 		UpdateLightRule(report);
 
 		// Only set when to update the tab
@@ -545,15 +829,103 @@ public:
 		return SendLightRuleReport(report);
 	}
 
-	void Reset() { myReporter->SendReset(); }
+	// While a batch is open, sensor, light rule and led mapping changes are only applied locally. Closing the
+	// outermost batch sends everything that changed: a handful of config block reports if the firmware has a config
+	// block, otherwise one report per changed item, no matter how often it changed during the batch.
+	void BeginBatch() { ++myBatchDepth; }
+
+	bool EndBatch()
+	{
+		if (myBatchDepth == 0 || --myBatchDepth > 0)
+			return true;
+
+		if (!myConfigBlock.empty())
+		{
+			if (myDirtyBegin < myDirtyEnd)
+			{
+				auto reporter = myReporter.get();
+				size_t offset = myDirtyBegin;
+				int sensorCount = myPad.numSensors;
+				vector<uint8_t> data(myConfigBlock.begin() + myDirtyBegin, myConfigBlock.begin() + myDirtyEnd);
+				PushWrite(CommandQueue::NO_KEY, [reporter, offset, data, sensorCount]()
+				{
+					bool result = reporter->WriteConfigBlock(data.data(), offset, data.size(), sensorCount);
+					if (!result)
+						Log::Write(L"PadDevice :: writing config block failed");
+					return result;
+				});
+			}
+		}
+		else
+		{
+			for (int sensorIndex : myPendingSensors)
+				PushSend(CommandQueue::Key(REPORT_SENSOR, sensorIndex), mySensors[sensorIndex].ToReport(sensorIndex));
+
+			for (auto& [index, report] : myPendingLightRules)
+				PushSend(CommandQueue::Key(REPORT_LIGHT_RULE, index), report);
+
+			for (auto& [index, report] : myPendingLedMappings)
+				PushSend(CommandQueue::Key(REPORT_LED_MAPPING, index), report);
+		}
+
+		if (myPadConfigurationPending)
+			SendPadConfiguration();
+
+		myDirtyBegin = myConfigBlock.size();
+		myDirtyEnd = 0;
+		myPendingSensors.clear();
+		myPendingLightRules.clear();
+		myPendingLedMappings.clear();
+		myPadConfigurationPending = false;
+		return true;
+	}
+
+	bool IsBatching() const { return myBatchDepth > 0; }
+
+	void StoreInConfigBlock(size_t offset, const void* data, size_t size)
+	{
+		if (offset + size > myConfigBlock.size())
+			return;
+
+		memcpy(myConfigBlock.data() + offset, data, size);
+
+		if (myBatchDepth > 0)
+		{
+			myDirtyBegin = min(myDirtyBegin, offset);
+			myDirtyEnd = max(myDirtyEnd, offset + size);
+		}
+	}
+
+	void Reset()
+	{
+		auto reporter = myReporter.get();
+		myCommands.Push(CommandQueue::NO_KEY, [reporter]() { reporter->SendReset(); return true; });
+	}
 
 	void FactoryReset()
 	{
 		// Have the device load up and save its defaults
-		myReporter->SendFactoryReset();
+		auto reporter = myReporter.get();
+		myCommands.Push(CommandQueue::NO_KEY, [reporter]() { reporter->SendFactoryReset(); return true; });
 	}
 
 	bool SendPadConfiguration()
+	{
+		if (IsBatching())
+		{
+			myPadConfigurationPending = true;
+			NotifyUnsavedChanges();
+			return true;
+		}
+
+		PadConfigurationReport report = ToPadConfigurationReport();
+		PushSendAndGet(CommandQueue::Key(REPORT_PAD_CONFIGURATION), report);
+
+		NotifyUnsavedChanges();
+		return true;
+	}
+
+	PadConfigurationReport ToPadConfigurationReport() const
 	{
 		PadConfigurationReport report;
 		for (int i = 0; i < myPad.numSensors; ++i)
@@ -562,13 +934,33 @@ public:
 			report.sensorToButtonMapping[i] = (mySensors[i].button == 0) ? 0xFF : (mySensors[i].button - 1);
 		}
 		report.releaseThreshold = WriteF32LE((float)myPad.releaseThreshold);
+		return report;
+	}
 
-		bool result = myReporter->SendAndGet(report);
+	// Records every sensor values report that comes in, until the recording is stopped.
+	bool StartRecording(const char* path)
+	{
+		CaptureHeader header;
+		header.identification = myIdentification;
+		header.configuration = ToPadConfigurationReport();
+		header.name.size = (uint8_t)min(myPad.name.size(), (size_t)MAX_NAME_LENGTH);
+		memcpy(header.name.name, myPad.name.data(), header.name.size);
 
-		NotifyUnsavedChanges();
-		return result;
+		if (!myRecorder.Open(path, header))
+			return false;
+
+		UpdateAnalogStream();
+		return true;
 	}
 
+	void StopRecording()
+	{
+		myRecorder.Close();
+		UpdateAnalogStream();
+	}
+
+	bool IsRecording() const { return myRecorder.IsOpen(); }
+
 	void NotifyUnsavedChanges()
 	{
 		myHasUnsavedChanges = true;
@@ -584,7 +976,8 @@ public:
 	{
 		if (myHasUnsavedChanges)
 		{
-			myReporter->SendSaveConfiguration();
+			auto reporter = myReporter.get();
+			PushWrite(CommandQueue::Key(REPORT_SAVE_CONFIGURATION), [reporter]() { return reporter->SendSaveConfiguration(); });
 			myHasUnsavedChanges = false;
 		}
 	}
@@ -595,6 +988,21 @@ public:
 
 	const PadState& State() const { return myPad; }
 
+	int SensorHistory(int sensorIndex, double seconds, int numColumns, vector<SensorRange>& ranges)
+	{
+		int rate = (myPollingData.pollingRate > 0) ? myPollingData.pollingRate : DEFAULT_HISTORY_RATE;
+		int numSamples = (int)lround(seconds * rate);
+
+		int result = myHistory.Columns(sensorIndex, numSamples, numColumns, myHistoryColumns);
+		ranges.resize(myHistoryColumns.size());
+		for (size_t i = 0; i < ranges.size(); ++i)
+		{
+			ranges[i].min = ToNormalizedSensorValue(myHistoryColumns[i].min);
+			ranges[i].max = ToNormalizedSensorValue(myHistoryColumns[i].max);
+		}
+		return result;
+	}
+
 	const LightsState& Lights() const { return myLights; }
 
 	const SensorState* Sensor(int index)
@@ -608,18 +1016,45 @@ public:
 			return L"";
 		}
 
-		DebugReport report;
-		if (!myReporter->Get(report)) {
-			return L"";
+		// With the debug stream, the text comes in on the reader thread.
+		if (myPad.featureDebugStream)
+		{
+			lock_guard<mutex> lock(myDebugMutex);
+			wstring result;
+			result.swap(myDebugText);
+			return result;
 		}
 
-		int messageSize = ReadU16LE(report.messageSize);
+		// The debug report is read on the worker, the text collected since the previous call is returned. Every read
+		// is a control transfer, so it is only done when the interval passed or the previous packet was full.
+		auto now = steady_clock::now();
+		if (now >= myNextDebugPoll || myHasMoreDebug)
+		{
+			myNextDebugPoll = now + DEBUG_POLL_INTERVAL;
+			myHasMoreDebug = false;
 
-		if (messageSize == 0) {
-			return L"";
+			auto reporter = myReporter.get();
+			myCommands.Push(CommandQueue::Key(REPORT_DEBUG), [this, reporter]()
+			{
+				DebugReport report;
+				if (!reporter->Get(report))
+					return false;
+
+				int messageSize = ReadU16LE(report.messageSize);
+				if (messageSize > 0)
+				{
+					lock_guard<mutex> lock(myDebugMutex);
+					myDebugText += widen(report.messagePacket, messageSize);
+				}
+				myHasMoreDebug = messageSize >= (int)sizeof(report.messagePacket);
+				return true;
+			});
 		}
 
-		return widen(report.messagePacket, messageSize);
+		lock_guard<mutex> lock(myDebugMutex);
+		wstring result;
+		result.swap(myDebugText);
+		return result;
 	}
 
 	DeviceChanges PopChanges()
@@ -636,7 +1071,9 @@ public:
 
 private:
 	unique_ptr<Reporter> myReporter;
+	CommandQueue myCommands;
 	DevicePath myPath;
+	IdentificationV2Report myIdentification;
 	PadState myPad;
 	LightsState myLights;
 	SensorState mySensors[MAX_SENSOR_COUNT];
@@ -644,17 +1081,48 @@ private:
 	bool myHasUnsavedChanges = false;
 	time_point<system_clock> myLastPendingChange;
 	PollingData myPollingData;
+	RingBuffer<SensorSample, SENSOR_SAMPLE_BUFFER_SIZE> mySamples;
+	CaptureWriter myRecorder;
+	SampleHistory myHistory;
+	vector<SampleRange> myHistoryColumns;
+	LatencyStats myLatency;
+	bool myIsTimingInput = false;
+	bool myIsSensorStreamRequested = false;
+	bool myIsAnalogStream = false;
+	atomic<bool> myHasFailedWrites = false;
+	atomic<int> myDroppedSamples = 0;
+	atomic<bool> myReadFailed = false;
+	atomic<bool> myIsReading = false;
+	thread myReaderThread;
+	atomic<int> myReportRate = 0;
+	atomic<uint32_t> myMissedFrames = 0;
+	mutex myStatsMutex;
+	PadStats myStats;
+	bool myHasStats = false;
+	mutex myDebugMutex;
+	wstring myDebugText;
+	time_point<steady_clock> myNextDebugPoll;
+	atomic<bool> myHasMoreDebug = false;
+	vector<uint8_t> myConfigBlock;
+	size_t myDirtyBegin = SIZE_MAX;
+	size_t myDirtyEnd = 0;
+	set<int> myPendingSensors;
+	map<int, LightRuleReport> myPendingLightRules;
+	map<int, LedMappingReport> myPendingLedMappings;
+	bool myPadConfigurationPending = false;
+	int myBatchDepth = 0;
 };
 
 // ====================================================================================================================
 // Connection manager.
 // ====================================================================================================================
 
-static bool ContainsDevice(hid_device_info* devices, DevicePath path)
+static bool ContainsDevice(const vector<hid_device_info*>& deviceLists, DevicePath path)
 {
-	for (auto device = devices; device; device = device->next)
-		if (path == device->path)
-			return true;
+	for (auto devices : deviceLists)
+		for (auto device = devices; device; device = device->next)
+			if (path == device->path)
+				return true;
 
 	return false;
 }
@@ -664,20 +1132,83 @@ class ConnectionManager
 public:
 	~ConnectionManager()
 	{
-		if (myConnectedDevice)
-			myConnectedDevice->SaveChanges();
+		for (auto& device : myConnectedDevices)
+			device->SaveChanges();
 	}
 
-	PadDevice* ConnectedDevice() const { return myConnectedDevice.get(); }
+	// The selected device is the one the unindexed device API operates on.
+	PadDevice* ConnectedDevice() const { return DeviceAt(mySelectedDevice); }
 
-	bool DiscoverDevice()
+	PadDevice* DeviceAt(int index) const
+	{
+		if (index < 0 || index >= (int)myConnectedDevices.size())
+			return nullptr;
+
+		return myConnectedDevices[index].get();
+	}
+
+	int NumDevices() const { return (int)myConnectedDevices.size(); }
+
+	int SelectedDevice() const { return mySelectedDevice; }
+
+	bool SelectDevice(int index)
+	{
+		if (index < 0 || index >= (int)myConnectedDevices.size() || index == mySelectedDevice)
+			return false;
+
+		mySelectedDevice = index;
+		return true;
+	}
+
+	// Asks all pads, including the ones that connect later, to stream sensor values.
+	void SetSensorStream(bool enabled)
+	{
+		mySensorStream = enabled;
+		for (auto& device : myConnectedDevices)
+			device->SetSensorStream(enabled);
+	}
+
+	bool IsConnected(const DevicePath& path) const
 	{
-		if(emulator) {
-			auto reporter = make_unique<Reporter>();
-			return ConnectToDeviceStage2(reporter, NULL);
+		for (auto& device : myConnectedDevices)
+		{
+			if (device->Path() == path)
+				return true;
+		}
+		return false;
+	}
+
+	// Returns true if devices might have been plugged in or unplugged since the last discovery.
+	bool ShouldDiscover()
+	{
+		vector<DevicePath> changedPaths;
+		bool discover = myHotplug.PollChanges(changedPaths);
+
+		// A device that is plugged in again is treated as a new device, even if it failed before.
+		for (auto& path : changedPaths)
+		{
+			auto it = myFailedDevices.find(path);
+			if (it != myFailedDevices.end())
+			{
+				Log::Writef(L"ConnectionManager :: failed device removed (%hs)", it->second.data());
+				myFailedDevices.erase(it);
+			}
 		}
 
-		auto foundDevices = hid_enumerate(0x0, 0x0);
+		return discover;
+	}
+
+	void RequestDiscovery() { myHotplug.RequestCheck(); }
+
+	// Connects every compatible device that is not connected yet. Returns true if any device was added.
+	bool DiscoverDevice()
+	{
+		int numDevices = NumDevices();
+
+		// Only enumerate compatible devices, enumerating everything is slow on machines with many HID devices.
+		vector<hid_device_info*> foundDevices;
+		for (auto id : HID_IDS)
+			foundDevices.push_back(hid_enumerate(id.vendorId, id.productId));
 
 		// Devices that are incompatible or had a communication failure are tracked in a failed device list to prevent
 		// a loop of reconnection attempts. Remove unplugged devices from the list. Then, the user can attempt to
@@ -693,40 +1224,43 @@ public:
 			else ++it;
 		}
 
-		// Try to connect to the first compatible device that is not on the failed device list.
+		// Try to connect to every compatible device that is not connected yet or on the failed device list.
+		// Hotplug notifications come in after udev rules ran. Without them, give the rules some time to run for
+		// devices that were plugged in since the previous enumeration.
 
-		for (auto device = foundDevices; device; device = device->next)
+		set<DevicePath> knownPaths;
+		for (auto devices : foundDevices)
 		{
-			if (myFailedDevices.count(device->path) == 0 && ConnectToDeviceStage1(device))
-				break;
+			for (auto device = devices; device; device = device->next)
+			{
+				bool waitForUdev = !myHotplug.HasNotifications() && myHasEnumerated && myKnownPaths.count(device->path) == 0;
+				knownPaths.insert(device->path);
+
+				if (myFailedDevices.count(device->path) == 0 && !IsConnected(device->path))
+					ConnectToDeviceStage1(device, waitForUdev);
+			}
+
+			hid_free_enumeration(devices);
 		}
 
-		hid_free_enumeration(foundDevices);
-		return (bool)myConnectedDevice;
+		myKnownPaths = move(knownPaths);
+		myHasEnumerated = true;
+		return NumDevices() > numDevices;
 	}
 
-	bool ConnectToDeviceStage1(hid_device_info* deviceInfo)
+	bool ConnectToDeviceStage1(hid_device_info* deviceInfo, bool waitForUdev)
 	{
 		// Check if the vendor and product are compatible.
 
-		bool compatible = false;
+		if (!IsCompatibleDevice(deviceInfo->vendor_id, deviceInfo->product_id))
+			return false;
 
-		for (auto id : HID_IDS)
+		if (waitForUdev)
 		{
-			if (deviceInfo->vendor_id == id.vendorId && deviceInfo->product_id == id.productId)
-			{
-				compatible = true;
-				break;
-			}
+			using namespace std::chrono_literals;
+			std::this_thread::sleep_for(200ms);
 		}
 
-		if (!compatible)
-			return false;
-
-		using namespace std::chrono_literals;
-		// Wait for any udev rules to run
-		std::this_thread::sleep_for(200ms);
-
 		// Open and configure HID for communicating with the pad.
 
 		auto hid = hid_open_path(deviceInfo->path);
@@ -759,7 +1293,48 @@ public:
 		return result;
 	}
 
-	bool ConnectToDeviceStage2(unique_ptr<Reporter>& reporter, hid_device_info* deviceInfo)
+	// Connects an emulated pad as an extra device and selects it.
+	bool ConnectEmulator(const EmulatorSettings& settings)
+	{
+		string devicePath = "emulator:" + to_string(myNumEmulators + 1);
+
+		auto reporter = make_unique<Reporter>(make_unique<PadEmulator>(settings));
+		if (!ConnectEmulatedDevice(reporter, devicePath))
+			return false;
+
+		++myNumEmulators;
+		return true;
+	}
+
+	// Connects a capture file as an extra device, which replays the recorded sensor values, and selects it.
+	bool ConnectReplay(const char* path, double speed)
+	{
+		string devicePath = string("replay:") + path;
+		if (IsConnected(devicePath))
+			return false;
+
+		auto replay = make_unique<CaptureReplay>(speed);
+		if (!replay->Open(path))
+			return false;
+
+		auto reporter = make_unique<Reporter>(make_unique<PadEmulator>(EmulatorSettings(), move(replay)));
+		return ConnectEmulatedDevice(reporter, devicePath);
+	}
+
+	bool ConnectEmulatedDevice(unique_ptr<Reporter>& reporter, const string& devicePath)
+	{
+		if (!ConnectToDeviceStage2(reporter, NULL, devicePath.c_str()))
+			return false;
+
+		for (int i = 0; i < NumDevices(); ++i)
+		{
+			if (myConnectedDevices[i]->Path() == devicePath)
+				mySelectedDevice = i;
+		}
+		return true;
+	}
+
+	bool ConnectToDeviceStage2(unique_ptr<Reporter>& reporter, hid_device_info* deviceInfo, const char* emulatedPath = "")
 	{
 		NameReport name;
 		IdentificationReport padIdentification;
@@ -804,10 +1379,48 @@ public:
 			}
 		}
 
+		// Newer firmware hands out the whole sensor and lights configuration in a few config block reports.
+		vector<uint8_t> configBlock;
+		if (padVersion.IsNewer({ 1, 3 }))
+		{
+			configBlock.resize(ConfigBlockSize(padIdentificationV2.sensorCount));
+			if (!reporter->ReadConfigBlock(configBlock.data(), 0, configBlock.size()))
+			{
+				Log::Write(L"ConnectionManager :: reading config block failed, falling back to separate reports");
+				configBlock.clear();
+			}
+		}
+
 		// If we got some lights, try to read the light rules.
 		vector<LightRuleReport> lightRules;
 		vector<LedMappingReport> ledMappings;
-		if (padIdentification.ledCount > 0 && padVersion.IsNewer({1, 1}))
+		if (padIdentification.ledCount > 0 && !configBlock.empty())
+		{
+			for (int i = 0; i < MAX_LIGHT_RULES; ++i)
+			{
+				LightRuleReport lightReport;
+				lightReport.lightRuleIndex = i;
+				memcpy(&lightReport.flags, configBlock.data() + LightRuleBlockOffset(padIdentificationV2.sensorCount, i), CONFIG_BLOCK_LIGHT_RULE_SIZE);
+				if (lightReport.flags & LRF_ENABLED)
+				{
+					PrintLightRuleReport(lightReport);
+					lightRules.push_back(lightReport);
+				}
+			}
+
+			for (int i = 0; i < MAX_LED_MAPPINGS; ++i)
+			{
+				LedMappingReport ledReport;
+				ledReport.ledMappingIndex = i;
+				memcpy(&ledReport.flags, configBlock.data() + LedMappingBlockOffset(padIdentificationV2.sensorCount, i), CONFIG_BLOCK_LED_MAPPING_SIZE);
+				if (ledReport.flags & LMF_ENABLED)
+				{
+					PrintLedMappingReport(ledReport);
+					ledMappings.push_back(ledReport);
+				}
+			}
+		}
+		else if (padIdentification.ledCount > 0 && padVersion.IsNewer({1, 1}))
 		{
 			SetPropertyReport selectReport;
 
@@ -844,12 +1457,21 @@ public:
 		if(deviceInfo != NULL) {
 			devicePath = deviceInfo->path;
 		}
-		else if(emulator) {
-			devicePath = "Dummy";
+		else {
+			devicePath = emulatedPath;
 		}
 
 		SensorReport sensorReport;
-		if (padVersion.IsNewer({ 1, 2 })) {
+		if (!configBlock.empty()) {
+			for (int i = 0; i < padIdentificationV2.sensorCount; ++i)
+			{
+				sensorReport.index = i;
+				memcpy(&sensorReport.threshold, configBlock.data() + SensorBlockOffset(i), CONFIG_BLOCK_SENSOR_SIZE);
+				PrintSensorReport(sensorReport);
+				sensors.push_back(sensorReport);
+			}
+		}
+		else if (padVersion.IsNewer({ 1, 2 })) {
 			SetPropertyReport selectReport;
 			selectReport.propertyId = WriteU32LE(SetPropertyReport::SELECTED_SENSOR_INDEX);
 
@@ -890,7 +1512,10 @@ public:
 			padIdentificationV2,
 			lightRules,
 			ledMappings,
-			sensors);
+			sensors,
+			configBlock);
+
+		device->SetSensorStream(mySensorStream);
 
 		Log::Write(L"ConnectionManager :: new device connected [");
 		Log::Writef(L"  Name: %hs", device->State().name.c_str());
@@ -903,24 +1528,43 @@ public:
 			Log::Writef(L"  Path: %hs", deviceInfo->path);
 		}
 		else {
-			Log::Writef(L"  Product: Dummy");
+			Log::Writef(L"  Product: %hs", devicePath.c_str());
 		}
 		Log::Write(L"]");
 
-		myConnectedDevice.reset(device);
+		// Devices are ordered by path, so the same USB ports end up at the same index regardless of connection order.
+		auto selected = ConnectedDevice();
+		auto position = myConnectedDevices.begin();
+		while (position != myConnectedDevices.end() && (*position)->Path() < device->Path())
+			++position;
+		myConnectedDevices.emplace(position, device);
+		mySelectedDevice = selected ? IndexOf(selected) : 0;
+
 		return true;
 	}
 
-	void DisconnectFailedDevice()
+	void DisconnectFailedDevice(int index)
 	{
-		auto device = myConnectedDevice.get();
+		auto device = DeviceAt(index);
 		if (device)
 		{
+			auto selected = ConnectedDevice();
 			myFailedDevices[device->Path()] = device->State().name;
-			myConnectedDevice.reset();
+			myConnectedDevices.erase(myConnectedDevices.begin() + index);
+			mySelectedDevice = (selected && selected != device) ? IndexOf(selected) : 0;
 		}
 	}
 
+	int IndexOf(const PadDevice* device) const
+	{
+		for (int i = 0; i < (int)myConnectedDevices.size(); ++i)
+		{
+			if (myConnectedDevices[i].get() == device)
+				return i;
+		}
+		return -1;
+	}
+
 	void AddIncompatibleDevice(hid_device_info* device)
 	{
 		if (device->product_string) // Can be null on failure, apparently.
@@ -928,9 +1572,14 @@ public:
 	}
 
 private:
-	unique_ptr<PadDevice> myConnectedDevice;
+	vector<unique_ptr<PadDevice>> myConnectedDevices;
+	int mySelectedDevice = 0;
 	map<DevicePath, DeviceName> myFailedDevices;
-	bool emulator = false;
+	HotplugWatcher myHotplug{ IsCompatibleDevice };
+	set<DevicePath> myKnownPaths;
+	bool myHasEnumerated = false;
+	int myNumEmulators = 0;
+	bool mySensorStream = false;
 };
 
 // ====================================================================================================================
@@ -939,6 +1588,7 @@ private:
 
 static ConnectionManager* connectionManager = nullptr;
 static bool searching = true;
+static DeviceChanges pendingChanges = 0;
 
 void Device::Init()
 {
@@ -959,25 +1609,27 @@ void Device::Shutdown()
 
 DeviceChanges Device::Update()
 {
-	DeviceChanges changes = 0;
+	DeviceChanges changes = pendingChanges;
+	pendingChanges = 0;
 
-	// If there is currently no connected device, try to find one.
-	auto device = connectionManager->ConnectedDevice();
-	if (!device && searching)
+	// Look for devices, but only when devices might have been plugged in.
+	if (searching && connectionManager->ShouldDiscover())
 	{
 		if (connectionManager->DiscoverDevice())
 			changes |= DCF_DEVICE;
-
-		device = connectionManager->ConnectedDevice();
 	}
 
-	// If there is a device, update it.
-	if (device)
+	// Update all devices. Only changes of the selected device are reported, other devices are not shown.
+	for (int i = connectionManager->NumDevices() - 1; i >= 0; --i)
 	{
-		changes |= device->PopChanges();
+		auto device = connectionManager->DeviceAt(i);
+		auto deviceChanges = device->PopChanges();
+		if (i == connectionManager->SelectedDevice())
+			changes |= deviceChanges;
+
 		if (!device->UpdateSensorValues())
 		{
-			connectionManager->DisconnectFailedDevice();
+			connectionManager->DisconnectFailedDevice(i);
 			changes |= DCF_DEVICE;
 		}
 	}
@@ -985,6 +1637,40 @@ DeviceChanges Device::Update()
 	return changes;
 }
 
+int Device::NumDevices()
+{
+	return connectionManager->NumDevices();
+}
+
+int Device::SelectedDevice()
+{
+	return connectionManager->SelectedDevice();
+}
+
+void Device::SelectDevice(int deviceIndex)
+{
+	if (connectionManager->SelectDevice(deviceIndex))
+		pendingChanges |= DCF_DEVICE;
+}
+
+int Device::PollingRate(int deviceIndex)
+{
+	auto device = connectionManager->DeviceAt(deviceIndex);
+	return device ? device->PollingRate() : 0;
+}
+
+const PadState* Device::Pad(int deviceIndex)
+{
+	auto device = connectionManager->DeviceAt(deviceIndex);
+	return device ? &device->State() : nullptr;
+}
+
+const SensorState* Device::Sensor(int deviceIndex, int sensorIndex)
+{
+	auto device = connectionManager->DeviceAt(deviceIndex);
+	return device ? device->Sensor(sensorIndex) : nullptr;
+}
+
 int Device::PollingRate()
 {
 	auto device = connectionManager->ConnectedDevice();
@@ -1009,6 +1695,17 @@ const SensorState* Device::Sensor(int sensorIndex)
 	return device ? device->Sensor(sensorIndex) : nullptr;
 }
 
+int Device::SensorHistory(int sensorIndex, double seconds, int numColumns, vector<SensorRange>& ranges)
+{
+	auto device = connectionManager->ConnectedDevice();
+	if (!device)
+	{
+		ranges.clear();
+		return 0;
+	}
+	return device->SensorHistory(sensorIndex, seconds, numColumns, ranges);
+}
+
 wstring Device::ReadDebug()
 {
 	auto device = connectionManager->ConnectedDevice();
@@ -1039,6 +1736,12 @@ bool Device::SetAdcConfig(int sensorIndex, int resistorValue)
 	return device ? device->SetAdcConfig(sensorIndex, resistorValue) : false;
 }
 
+bool Device::SetFilterConfig(int sensorIndex, int oversampleShift, bool medianFilter)
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device ? device->SetFilterConfig(sensorIndex, oversampleShift, medianFilter) : false;
+}
+
 bool Device::SetButtonMapping(int sensorIndex, int button)
 {
 	auto device = connectionManager->ConnectedDevice();
@@ -1093,13 +1796,132 @@ void Device::SaveChanges()
 	if (device) device->SaveChanges();
 }
 
+bool Device::FlushWrites()
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device && device->FlushCommands();
+}
+
+void Device::SetSensorStream(bool enabled)
+{
+	connectionManager->SetSensorStream(enabled);
+}
+
+bool Device::StartRecording(const string& path)
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device && device->StartRecording(path.c_str());
+}
+
+void Device::StopRecording()
+{
+	for (int i = 0; i < connectionManager->NumDevices(); ++i)
+		connectionManager->DeviceAt(i)->StopRecording();
+}
+
+bool Device::IsRecording()
+{
+	for (int i = 0; i < connectionManager->NumDevices(); ++i)
+	{
+		if (connectionManager->DeviceAt(i)->IsRecording())
+			return true;
+	}
+	return false;
+}
+
+bool Device::SetInputTiming(bool enabled)
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device && device->SetInputTiming(enabled);
+}
+
+bool Device::IsTimingInput()
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device && device->IsTimingInput();
+}
+
+bool Device::Latency(LatencySummary& summary)
+{
+	auto device = connectionManager->ConnectedDevice();
+	if (!device || !device->HasLatency())
+		return false;
+
+	summary = device->Latency();
+	return true;
+}
+
+void Device::ResetLatency()
+{
+	auto device = connectionManager->ConnectedDevice();
+	if (device) device->ResetLatency();
+}
+
+bool Device::Stats(PadStats& stats)
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device && device->Stats(stats);
+}
+
+void Device::ResetStats()
+{
+	auto device = connectionManager->ConnectedDevice();
+	if (device) device->ResetStats();
+}
+
+bool Device::ExportLatency(const string& path)
+{
+	auto device = connectionManager->ConnectedDevice();
+	if (!device || !device->HasLatency())
+		return false;
+
+	// Label the results with the pad and firmware, the name is sanitized to keep the CSV valid.
+	auto& pad = device->State();
+	string name = pad.name;
+	replace(name.begin(), name.end(), '"', '\'');
+	auto board = BoardTypeToString(pad.boardType);
+	char label[128];
+	snprintf(label, sizeof(label), "%s (%s, firmware %i.%i)", name.c_str(), narrow(board, wcslen(board)).c_str(),
+		pad.firmwareVersion.major, pad.firmwareVersion.minor);
+
+	return LatencyStats::Export(path.c_str(), label, device->Latency());
+}
+
+bool Device::ConnectEmulator(const EmulatorSettings& settings)
+{
+	if (!connectionManager->ConnectEmulator(settings))
+		return false;
+
+	pendingChanges |= DCF_DEVICE;
+	return true;
+}
+
+bool Device::ReplayCapture(const string& path, double speed)
+{
+	if (!connectionManager->ConnectReplay(path.c_str(), speed))
+		return false;
+
+	pendingChanges |= DCF_DEVICE;
+	return true;
+}
+
 void Device::SetSearching(bool s)
 {
+	// Devices that were plugged in while not searching are picked up right away.
+	if (s && !searching)
+		connectionManager->RequestDiscovery();
+
 	searching = s;
 }
 
 void Device::LoadProfile(json& j, DeviceProfileGroups groups)
 {
+	auto device = connectionManager->ConnectedDevice();
+	if (!device)
+		return;
+
+	device->BeginBatch();
+
 	if((groups & DPG_LIGHTS) > 0 && Pad()->featureLights) {
 		if(j["ledMappings"].is_array()) {
 			for(int key = 0; key < j["ledMappings"].size(); key++) {
@@ -1133,10 +1955,7 @@ void Device::LoadProfile(json& j, DeviceProfileGroups groups)
 			}
 		}
 
-		auto device = connectionManager->ConnectedDevice();
-		if(device) {
-            device->TriggerChange(DCF_LIGHTS);
-		}
+		device->TriggerChange(DCF_LIGHTS);
 	}
 
 	if (j["sensors"].is_array()) {
@@ -1154,6 +1973,10 @@ void Device::LoadProfile(json& j, DeviceProfileGroups groups)
 			if (groups & DPG_MAPPING && sensor.contains("resistorValue") && Pad()->featureDigipot) {
 				SetAdcConfig(key, sensor["resistorValue"]);
 			}
+
+			if (groups & DPG_MAPPING && sensor.contains("oversampleShift") && Pad()->featureFiltering) {
+				SetFilterConfig(key, sensor["oversampleShift"], sensor.value("medianFilter", false));
+			}
 		}
 	}
 
@@ -1163,6 +1986,8 @@ void Device::LoadProfile(json& j, DeviceProfileGroups groups)
 		}
 	}
 
+	device->EndBatch();
+
 	if(groups & DPG_DEVICE) {
 		string name = j["name"];
 		SetDeviceName( ((std::string)j["name"]).c_str() );
@@ -1171,7 +1996,7 @@ void Device::LoadProfile(json& j, DeviceProfileGroups groups)
 
 void Device::SaveProfile(json& j, DeviceProfileGroups groups)
 {
-	j["adpToolVersion"] = wxString::Format("v%i.%i", ADP_VERSION_MAJOR, ADP_VERSION_MINOR);
+	j["adpToolVersion"] = "v" + to_string(ADP_VERSION_MAJOR) + "." + to_string(ADP_VERSION_MINOR);
 
 	if((groups & DPG_LIGHTS) && Pad()->featureLights && Lights()) {
 		auto lights = Lights();
@@ -1208,6 +2033,8 @@ void Device::SaveProfile(json& j, DeviceProfileGroups groups)
 			if (groups & DPG_MAPPING) {
 				j["sensors"][i]["button"] = Device::Sensor(i)->button;
 				j["sensors"][i]["resistorValue"] = Device::Sensor(i)->resistorValue;
+				j["sensors"][i]["oversampleShift"] = Device::Sensor(i)->oversampleShift;
+				j["sensors"][i]["medianFilter"] = Device::Sensor(i)->medianFilter;
 			}
 		}
 
@@ -3,15 +3,13 @@
 #include "stdint.h"
 #include <string>
 #include <map>
-#include "wx/string.h"
-#include "wx/colour.h"
+#include <vector>
 
 #include <nlohmann/json.hpp>
 using json = nlohmann::json;
 
-#include "Model/Firmware.h"
+#include "Model/Board.h"
 #include "Model/Reporter.h"
-#include "Model/Updater.h"
 
 namespace adp {
 
@@ -43,14 +41,8 @@ struct RgbColor
 		:red(r),green(g),blue(b)
 	{ ; }
 
-	RgbColor(std::string input)
-		:red(0), green(0), blue(0)
-	{
-		wxColour c(input);
-		red = c.Red();
-		green = c.Green();
-		blue = c.Blue();
-	}
+	// Parses an HTML style "#RRGGBB" color, anything else results in black.
+	RgbColor(std::string input);
 
 	RgbColor()
 		:red(0), green(0), blue(0)
@@ -62,9 +54,8 @@ struct RgbColor
 	uint8_t green;
 	uint8_t blue;
 
-	const std::string ToString() const {
-		return wxColour(red, green, blue).GetAsString(wxC2S_HTML_SYNTAX).ToStdString();
-	}
+	// Formats the color as an HTML style "#RRGGBB" string.
+	const std::string ToString() const;
 };
 
 struct SensorState
@@ -73,12 +64,38 @@ struct SensorState
 	double releaseThreshold = 0.0;
 	double value = 0.0;
 	int resistorValue = 0;
+	int oversampleShift = 0; // 2^oversampleShift samples are averaged per value.
+	bool medianFilter = false;
+	uint16_t otherFlags = 0; // flags the tool does not edit, like ADC_DISABLED, they are sent back as they are.
 	int button = 0; // zero means unmapped.
 	bool pressed = false;
 
 	SensorReport ToReport(int index);
 };
 
+// Lowest and highest value of a sensor during a stretch of time.
+struct SensorRange
+{
+	double min = 0.0;
+	double max = 0.0;
+};
+
+struct StageStats
+{
+	int averageMicros = 0; // over the last second.
+	int maxMicros = 0; // since the pad started or the stats were reset.
+	int runsPerSecond = 0;
+};
+
+// Performance counters measured on the pad.
+struct PadStats
+{
+	StageStats stages[NUM_STATS_STAGES];
+	int adcConversionsPerSecond = 0;
+	int reportRate = 0;
+	uint32_t missedFrames = 0;
+};
+
 struct PadState
 {
 	std::string name;
@@ -88,9 +105,14 @@ struct PadState
 	double releaseThreshold = 1.0;
 	BoardType boardType = BOARD_UNKNOWN;
 	bool featureDebug;
+	bool featureDebugStream;
 	bool featureDigipot;
 	bool featureLights;
+	bool featureFiltering;
+	bool featureStats;
 	VersionType firmwareVersion = versionTypeUnknown;
+	int reportRate = 0; // input reports per second as measured by the pad, zero if unknown.
+	uint32_t missedFrames = 0; // USB frames in which the pad did not send an input report.
 };
 
 struct LedMapping
@@ -117,6 +139,9 @@ struct LightsState
 	std::map<int, LedMapping> ledMappings;
 };
 
+struct EmulatorSettings;
+struct LatencySummary;
+
 class Device
 {
 public:
@@ -134,6 +159,24 @@ public:
 
 	static const SensorState* Sensor(int sensorIndex);
 
+	// Gives the range of values of a sensor per column, for the given time until now, using every report. See
+	// SampleHistory::Columns for the result.
+	static int SensorHistory(int sensorIndex, double seconds, int numColumns, std::vector<SensorRange>& ranges);
+
+	// Every compatible pad is connected. The functions without a device index operate on the selected device.
+
+	static int NumDevices();
+
+	static int SelectedDevice();
+
+	static void SelectDevice(int deviceIndex);
+
+	static int PollingRate(int deviceIndex);
+
+	static const PadState* Pad(int deviceIndex);
+
+	static const SensorState* Sensor(int deviceIndex, int sensorIndex);
+
 	static wstring ReadDebug();
 
 	static const bool HasUnsavedChanges();
@@ -142,6 +185,8 @@ public:
 
 	static bool SetAdcConfig(int sensorIndex, int resistorValue);
 
+	static bool SetFilterConfig(int sensorIndex, int oversampleShift, bool medianFilter);
+
 	static bool SetReleaseThreshold(double threshold);
 
 	static bool SetButtonMapping(int sensorIndex, int button);
@@ -162,6 +207,49 @@ public:
 
 	static void SaveChanges();
 
+	// Changes are sent to the pad in the background, this waits until everything queued so far has been sent. Returns
+	// false if a write to the selected device failed since the previous flush.
+	static bool FlushWrites();
+
+	// Newer pads only send buttons until they are asked to stream sensor values, so games keep their input. Views and
+	// commands that show sensor values turn the stream on while they do. Recording and latency measurement turn it on
+	// by themselves.
+	static void SetSensorStream(bool enabled);
+
+	// Records the raw sensor values of the selected device to a capture file. Stopping ends any recording.
+	static bool StartRecording(const string& path);
+
+	static void StopRecording();
+
+	static bool IsRecording();
+
+	// Makes the selected device send timestamps with its input reports, to measure latency. Needs firmware 1.5.
+	// Enabling starts a new measurement, the results stay available after disabling.
+	static bool SetInputTiming(bool enabled);
+
+	static bool IsTimingInput();
+
+	// Returns false if nothing was measured on the selected device.
+	static bool Latency(LatencySummary& summary);
+
+	static void ResetLatency();
+
+	// Appends the latency measured on the selected device to a CSV file.
+	static bool ExportLatency(const string& path);
+
+	// Returns false if the selected device does not measure its performance, or was not read yet. Needs a pad that
+	// announces FEATURE_STATS. The counters are read along with the report rate, once per second.
+	static bool Stats(PadStats& stats);
+
+	// Clears the maximum times measured by the selected device.
+	static void ResetStats();
+
+	// Connects a simulated pad as an extra device and selects it, for testing without hardware.
+	static bool ConnectEmulator(const EmulatorSettings& settings);
+
+	// Connects a capture file as an extra device and selects it. The speed scales the time between reports.
+	static bool ReplayCapture(const string& path, double speed);
+
 	static void LoadProfile(json& j, DeviceProfileGroups groups);
 
 	static void SaveProfile(json& j, DeviceProfileGroups groups);
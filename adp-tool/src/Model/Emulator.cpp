@@ -0,0 +1,582 @@
+#include "Adp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#include "Model/Emulator.h"
+#include "Model/Capture.h"
+#include "Model/Log.h"
+
+using namespace std;
+using namespace chrono;
+
+namespace adp {
+
+// The emulator behaves like this firmware version.
+constexpr uint16_t EMULATED_FIRMWARE_MAJOR = 1;
+constexpr uint16_t EMULATED_FIRMWARE_MINOR = 5;
+
+static const char* EMULATED_NAME = "ADP Emulator";
+static const char* EMULATED_BOARD_TYPE = "emulator";
+
+// Same defaults as the firmware.
+constexpr int DEFAULT_THRESHOLD = 400;
+constexpr double DEFAULT_RELEASE_MULTIPLIER = 0.95;
+constexpr int DEFAULT_RESISTOR_VALUE = 150;
+
+// Input reports that are not read right away wait in a buffer of the operating system. When it is full, the oldest
+// reports are lost.
+constexpr long long HOST_REPORT_BUFFER_SIZE = 64;
+
+// Shape of the synthetic presses, in device sensor values.
+constexpr int SENSOR_IDLE_LEVEL = 40;
+constexpr int SENSOR_PRESS_LEVEL = 650;
+constexpr int SENSOR_NOISE = 6;
+constexpr double PRESS_FRACTION = 0.3;
+constexpr double PI = 3.14159265358979323846;
+
+// ====================================================================================================================
+// Helper functions.
+// ====================================================================================================================
+
+template <typename T>
+static int Reply(const T& report, uint8_t* data, size_t length)
+{
+	if (length < sizeof(T))
+		return -1;
+
+	memcpy(data, &report, sizeof(T));
+	return (int)sizeof(T);
+}
+
+template <typename T>
+static bool Receive(T& report, const uint8_t* data, size_t length)
+{
+	if (length != sizeof(T))
+		return false;
+
+	memcpy(&report, data, sizeof(T));
+	return true;
+}
+
+// Every sensor is pressed in turn with its own rhythm, so the graphs and buttons show some activity.
+static int SyntheticSensorValue(int sensorIndex, double time, minstd_rand& random)
+{
+	double period = 0.8 + 0.23 * sensorIndex;
+	double phase = fmod(time + 0.17 * sensorIndex, period) / period;
+
+	double value = SENSOR_IDLE_LEVEL;
+	if (phase < PRESS_FRACTION)
+		value += SENSOR_PRESS_LEVEL * sin(PI * phase / PRESS_FRACTION);
+
+	value += uniform_int_distribution<int>(-SENSOR_NOISE, SENSOR_NOISE)(random);
+	return clamp((int)value, 0, MAX_SENSOR_VALUE);
+}
+
+// ====================================================================================================================
+// Pad emulator.
+// ====================================================================================================================
+
+PadEmulator::PadEmulator(const EmulatorSettings& settings)
+	: mySettings(settings)
+{
+	mySettings.numSensors = clamp(mySettings.numSensors, 1, MAX_SENSOR_COUNT);
+	mySettings.numButtons = clamp(mySettings.numButtons, 1, MAX_BUTTON_COUNT);
+	mySettings.reportRate = clamp(mySettings.reportRate, EmulatorSettings::MIN_REPORT_RATE, EmulatorSettings::MAX_REPORT_RATE);
+	mySettings.latencyUs = max(mySettings.latencyUs, 0);
+	mySettings.jitterUs = max(mySettings.jitterUs, 0);
+
+	myIdentification.firmwareMajor = WriteU16LE(EMULATED_FIRMWARE_MAJOR);
+	myIdentification.firmwareMinor = WriteU16LE(EMULATED_FIRMWARE_MINOR);
+	myIdentification.buttonCount = (uint8_t)mySettings.numButtons;
+	myIdentification.sensorCount = (uint8_t)mySettings.numSensors;
+	myIdentification.ledCount = (uint8_t)max(mySettings.numLeds, 0);
+	myIdentification.maxSensorValue = WriteU16LE(MAX_SENSOR_VALUE);
+	memset(myIdentification.boardType, 0, BOARD_TYPE_LENGTH);
+	strcpy(myIdentification.boardType, EMULATED_BOARD_TYPE);
+
+	int features = IdentificationV2Report::FEATURE_DEBUG | IdentificationV2Report::FEATURE_DEBUG_STREAM |
+		IdentificationV2Report::FEATURE_DIGIPOT | IdentificationV2Report::FEATURE_FILTERING |
+		IdentificationV2Report::FEATURE_STATS;
+	if (mySettings.numLeds > 0)
+		features |= IdentificationV2Report::FEATURE_LIGHTS;
+	myIdentification.features = WriteU16LE(features);
+
+	FactoryDefaults();
+	mySavedConfigBlock = myConfigBlock;
+
+	myStartTime = steady_clock::now();
+	myNextReport = myStartTime;
+	myWindowStart = myStartTime;
+	myReportInterval = duration_cast<steady_clock::duration>(nanoseconds(1000000000 / mySettings.reportRate));
+}
+
+PadEmulator::PadEmulator(const EmulatorSettings& settings, unique_ptr<CaptureReplay> replay)
+	: PadEmulator(settings)
+{
+	// Take over the identity and configuration of the recorded pad, but keep the capabilities of current firmware.
+	auto& header = replay->Header();
+	myIdentification.buttonCount = header.identification.buttonCount;
+	myIdentification.sensorCount = header.identification.sensorCount;
+	myIdentification.ledCount = header.identification.ledCount;
+	memcpy(myIdentification.boardType, header.identification.boardType, BOARD_TYPE_LENGTH);
+
+	mySettings.numSensors = clamp((int)header.identification.sensorCount, 1, MAX_SENSOR_COUNT);
+	mySettings.numButtons = clamp((int)header.identification.buttonCount, 1, MAX_BUTTON_COUNT);
+	mySettings.numLeds = header.identification.ledCount;
+
+	int features = ReadU16LE(myIdentification.features) & ~IdentificationV2Report::FEATURE_LIGHTS;
+	if (mySettings.numLeds > 0)
+		features |= IdentificationV2Report::FEATURE_LIGHTS;
+	myIdentification.features = WriteU16LE(features);
+
+	FactoryDefaults();
+	myName = header.name;
+
+	float releaseMultiplier = ReadF32LE(header.configuration.releaseThreshold);
+	for (int i = 0; i < mySettings.numSensors; ++i)
+	{
+		int threshold = ReadU16LE(header.configuration.sensorThresholds[i]);
+		auto report = SensorAt(i);
+		report.threshold = WriteU16LE(threshold);
+		report.releaseThreshold = WriteU16LE((int)(threshold * releaseMultiplier));
+		report.buttonMapping = header.configuration.sensorToButtonMapping[i];
+		memcpy(myConfigBlock.data() + SensorBlockOffset(i), &report.threshold, CONFIG_BLOCK_SENSOR_SIZE);
+	}
+	mySavedConfigBlock = myConfigBlock;
+
+	myReplay = move(replay);
+}
+
+PadEmulator::~PadEmulator()
+{
+}
+
+void PadEmulator::FactoryDefaults()
+{
+	myName = NameReport();
+	myName.size = (uint8_t)strlen(EMULATED_NAME);
+	memcpy(myName.name, EMULATED_NAME, myName.size);
+
+	// Light rules and led mappings start out disabled.
+	myConfigBlock.assign(ConfigBlockSize(mySettings.numSensors), 0);
+
+	for (int i = 0; i < mySettings.numSensors; ++i)
+	{
+		SensorReport report;
+		report.threshold = WriteU16LE(DEFAULT_THRESHOLD);
+		report.releaseThreshold = WriteU16LE((int)(DEFAULT_THRESHOLD * DEFAULT_RELEASE_MULTIPLIER));
+		report.buttonMapping = (int8_t)(i < mySettings.numButtons ? i : -1);
+		report.resistorValue = DEFAULT_RESISTOR_VALUE;
+		report.flags = WriteU16LE(0);
+		memcpy(myConfigBlock.data() + SensorBlockOffset(i), &report.threshold, CONFIG_BLOCK_SENSOR_SIZE);
+	}
+}
+
+SensorReport PadEmulator::SensorAt(int sensorIndex) const
+{
+	SensorReport report;
+	report.index = (uint8_t)sensorIndex;
+	if (sensorIndex < mySettings.numSensors)
+		memcpy(&report.threshold, myConfigBlock.data() + SensorBlockOffset(sensorIndex), CONFIG_BLOCK_SENSOR_SIZE);
+	else
+		memset(&report.threshold, 0, CONFIG_BLOCK_SENSOR_SIZE);
+	return report;
+}
+
+void PadEmulator::WaitForTransfer()
+{
+	int delay;
+	{
+		lock_guard<mutex> lock(myMutex);
+		uniform_int_distribution<int> jitter(-mySettings.jitterUs, mySettings.jitterUs);
+		delay = max(mySettings.latencyUs + jitter(myJitterRandom), 0);
+	}
+	this_thread::sleep_for(microseconds(delay));
+}
+
+int PadEmulator::GetFeatureReport(uint8_t* data, size_t length)
+{
+	WaitForTransfer();
+
+	lock_guard<mutex> lock(myMutex);
+	if (myIsDisconnected || length == 0)
+		return -1;
+
+	switch (data[0])
+	{
+	case REPORT_PAD_CONFIGURATION: {
+		PadConfigurationReport report;
+		for (int i = 0; i < MAX_SENSOR_COUNT; ++i)
+		{
+			auto sensor = SensorAt(i);
+			report.sensorThresholds[i] = sensor.threshold;
+			report.sensorToButtonMapping[i] = sensor.buttonMapping;
+		}
+		auto sensor = SensorAt(0);
+		int threshold = ReadU16LE(sensor.threshold);
+		report.releaseThreshold = WriteF32LE(threshold ? (float)ReadU16LE(sensor.releaseThreshold) / threshold : 1.0f);
+		return Reply(report, data, length);
+	}
+	case REPORT_NAME:
+		return Reply(myName, data, length);
+
+	case REPORT_IDENTIFICATION: {
+		IdentificationReport report = myIdentification;
+		report.reportId = REPORT_IDENTIFICATION;
+		myDebugText += "Welcome!\n";
+		return Reply(report, data, length);
+	}
+	case REPORT_IDENTIFICATION_V2:
+		myDebugText += "Welcome V2!\n";
+		return Reply(myIdentification, data, length);
+
+	case REPORT_IDENTIFICATION_V3: {
+		IdentificationV3Report report;
+		static_cast<IdentificationV2Report&>(report) = myIdentification;
+		report.reportId = REPORT_IDENTIFICATION_V3;
+		report.reportRate = WriteU16LE(myReportRate);
+		report.missedFrames = WriteU32LE(0);
+		return Reply(report, data, length);
+	}
+	case REPORT_LIGHT_RULE: {
+		LightRuleReport report;
+		report.lightRuleIndex = (uint8_t)mySelectedLightRule;
+		if (mySelectedLightRule < MAX_LIGHT_RULES)
+			memcpy(&report.flags, myConfigBlock.data() + LightRuleBlockOffset(mySettings.numSensors, mySelectedLightRule), CONFIG_BLOCK_LIGHT_RULE_SIZE);
+		else
+			memset(&report.flags, 0, CONFIG_BLOCK_LIGHT_RULE_SIZE);
+		return Reply(report, data, length);
+	}
+	case REPORT_LED_MAPPING: {
+		LedMappingReport report;
+		report.ledMappingIndex = (uint8_t)mySelectedLedMapping;
+		if (mySelectedLedMapping < MAX_LED_MAPPINGS)
+			memcpy(&report.flags, myConfigBlock.data() + LedMappingBlockOffset(mySettings.numSensors, mySelectedLedMapping), CONFIG_BLOCK_LED_MAPPING_SIZE);
+		else
+			memset(&report.flags, 0, CONFIG_BLOCK_LED_MAPPING_SIZE);
+		return Reply(report, data, length);
+	}
+	case REPORT_SENSOR:
+		return Reply(SensorAt(mySelectedSensor), data, length);
+
+	case REPORT_CONFIG_BLOCK: {
+		ConfigBlockReport report;
+		size_t offset = min(myConfigBlockOffset, myConfigBlock.size());
+		size_t chunk = min(myConfigBlock.size() - offset, (size_t)CONFIG_BLOCK_DATA_SIZE);
+		memset(report.data, 0, sizeof(report.data));
+		memcpy(report.data, myConfigBlock.data() + offset, chunk);
+		report.offset = WriteU16LE((int)offset);
+		report.length = (uint8_t)chunk;
+		myConfigBlockOffset = offset + chunk;
+		return Reply(report, data, length);
+	}
+	case REPORT_DEBUG: {
+		DebugReport report;
+		size_t size = min(myDebugText.size(), sizeof(report.messagePacket));
+		memset(report.messagePacket, 0, sizeof(report.messagePacket));
+		memcpy(report.messagePacket, myDebugText.data(), size);
+		report.messageSize = WriteU16LE((int)size);
+		myDebugText.erase(0, size);
+		return Reply(report, data, length);
+	}
+	case REPORT_STATS: {
+		// Only the pad update has a counterpart here, the emulated buttons are derived from the sensor values.
+		StatsReport report;
+		memset(report.stages, 0, sizeof(report.stages));
+		report.stages[STATS_PAD_UPDATE].averageMicros = WriteU16LE(myPadUpdateAverageUs);
+		report.stages[STATS_PAD_UPDATE].maxMicros = WriteU16LE(myPadUpdateMaxUs);
+		report.stages[STATS_PAD_UPDATE].runsPerSecond = WriteU32LE(myReportRate);
+		report.adcConversionsPerSecond = WriteU16LE(min(myReportRate * mySettings.numSensors, 0xFFFF));
+		report.reportRate = WriteU16LE(myReportRate);
+		report.missedFrames = WriteU32LE(0);
+		return Reply(report, data, length);
+	}
+	}
+
+	return -1;
+}
+
+int PadEmulator::SendFeatureReport(const uint8_t* data, size_t length)
+{
+	WaitForTransfer();
+
+	lock_guard<mutex> lock(myMutex);
+	if (myIsDisconnected || length == 0)
+		return -1;
+
+	switch (data[0])
+	{
+	case REPORT_PAD_CONFIGURATION: {
+		PadConfigurationReport report;
+		if (!Receive(report, data, length))
+			return -1;
+
+		float releaseMultiplier = ReadF32LE(report.releaseThreshold);
+		for (int i = 0; i < mySettings.numSensors; ++i)
+		{
+			auto sensor = SensorAt(i);
+			int threshold = ReadU16LE(report.sensorThresholds[i]);
+			sensor.threshold = report.sensorThresholds[i];
+			sensor.releaseThreshold = WriteU16LE((int)(threshold * releaseMultiplier));
+			sensor.buttonMapping = report.sensorToButtonMapping[i];
+			memcpy(myConfigBlock.data() + SensorBlockOffset(i), &sensor.threshold, CONFIG_BLOCK_SENSOR_SIZE);
+		}
+		return (int)length;
+	}
+	case REPORT_NAME: {
+		NameReport report;
+		if (!Receive(report, data, length))
+			return -1;
+
+		report.size = min(report.size, (uint8_t)MAX_NAME_LENGTH);
+		myName = report;
+		return (int)length;
+	}
+	case REPORT_LIGHT_RULE: {
+		LightRuleReport report;
+		if (!Receive(report, data, length))
+			return -1;
+
+		if (report.lightRuleIndex < MAX_LIGHT_RULES)
+			memcpy(myConfigBlock.data() + LightRuleBlockOffset(mySettings.numSensors, report.lightRuleIndex), &report.flags, CONFIG_BLOCK_LIGHT_RULE_SIZE);
+		return (int)length;
+	}
+	case REPORT_LED_MAPPING: {
+		LedMappingReport report;
+		if (!Receive(report, data, length))
+			return -1;
+
+		if (report.ledMappingIndex < MAX_LED_MAPPINGS)
+			memcpy(myConfigBlock.data() + LedMappingBlockOffset(mySettings.numSensors, report.ledMappingIndex), &report.flags, CONFIG_BLOCK_LED_MAPPING_SIZE);
+		return (int)length;
+	}
+	case REPORT_SENSOR: {
+		SensorReport report;
+		if (!Receive(report, data, length))
+			return -1;
+
+		if (report.index < mySettings.numSensors)
+			memcpy(myConfigBlock.data() + SensorBlockOffset(report.index), &report.threshold, CONFIG_BLOCK_SENSOR_SIZE);
+		return (int)length;
+	}
+	case REPORT_CONFIG_BLOCK: {
+		ConfigBlockReport report;
+		if (!Receive(report, data, length))
+			return -1;
+
+		size_t offset = ReadU16LE(report.offset);
+		if (report.length <= CONFIG_BLOCK_DATA_SIZE && offset + report.length <= myConfigBlock.size())
+			memcpy(myConfigBlock.data() + offset, report.data, report.length);
+		return (int)length;
+	}
+	case REPORT_SET_PROPERTY: {
+		SetPropertyReport report;
+		if (!Receive(report, data, length))
+			return -1;
+
+		uint32_t value = ReadU32LE(report.propertyValue);
+		switch (ReadU32LE(report.propertyId))
+		{
+		case SetPropertyReport::SELECTED_LIGHT_RULE_INDEX: mySelectedLightRule = (uint8_t)value; break;
+		case SetPropertyReport::SELECTED_LED_MAPPING_INDEX: mySelectedLedMapping = (uint8_t)value; break;
+		case SetPropertyReport::SELECTED_SENSOR_INDEX: mySelectedSensor = (uint8_t)value; break;
+		case SetPropertyReport::ANALOG_STREAM: myAnalogStream = (value != 0); break;
+		case SetPropertyReport::CONFIG_BLOCK_OFFSET: myConfigBlockOffset = (uint16_t)value; break;
+		case SetPropertyReport::INPUT_TIMING: myInputTiming = (value != 0); break;
+		case SetPropertyReport::DEBUG_STREAM: myDebugStream = (value != 0); break;
+		case SetPropertyReport::RESET_STATS: myPadUpdateMaxUs = 0; break;
+		}
+		return (int)length;
+	}
+	}
+
+	return -1;
+}
+
+int PadEmulator::Write(const uint8_t* data, size_t length)
+{
+	WaitForTransfer();
+
+	lock_guard<mutex> lock(myMutex);
+	if (myIsDisconnected || length == 0)
+		return -1;
+
+	switch (data[0])
+	{
+	case REPORT_RESET:
+		// The firmware jumps to the bootloader, so the pad is gone.
+		myIsDisconnected = true;
+		Log::Write(L"PadEmulator :: reset, disconnecting");
+		break;
+
+	case REPORT_SAVE_CONFIGURATION:
+		mySavedConfigBlock = myConfigBlock;
+		break;
+
+	case REPORT_FACTORY_RESET:
+		FactoryDefaults();
+		mySavedConfigBlock = myConfigBlock;
+		break;
+	}
+
+	return (int)length;
+}
+
+int PadEmulator::Read(uint8_t* data, size_t length, int timeoutMs)
+{
+	{
+		lock_guard<mutex> lock(myMutex);
+		if (myIsDisconnected)
+			return -1;
+	}
+
+	SensorValuesReport report;
+	auto reportTime = steady_clock::now();
+	if (myReplay)
+	{
+		auto result = myReplay->Read(report, timeoutMs);
+		if (result != ReadDataResult::SUCCESS)
+			return (result == ReadDataResult::NO_DATA) ? 0 : -1;
+	}
+	else
+	{
+		if (!NextSyntheticReport(report, timeoutMs))
+			return 0;
+		reportTime = myNextReport - myReportInterval;
+	}
+
+	// The pad clock counts microseconds from the start of the emulator. Sensors are scanned at some point during the
+	// interval before the report is handed to USB, that is when buttons change.
+	auto reportMicros = (uint32_t)duration_cast<microseconds>(reportTime - myStartTime).count();
+	auto intervalMicros = (uint32_t)duration_cast<microseconds>(myReportInterval).count();
+	auto scanMicros = reportMicros - uniform_int_distribution<uint32_t>(0, intervalMicros)(myNoiseRandom);
+
+	lock_guard<mutex> lock(myMutex);
+	auto updateStart = steady_clock::now();
+	UpdateButtons(report, (uint16_t)scanMicros);
+	auto updateMicros = (int)duration_cast<microseconds>(steady_clock::now() - updateStart).count();
+	myPadUpdateTotalUs += updateMicros;
+	myPadUpdateMaxUs = min(max(myPadUpdateMaxUs, updateMicros), 0xFFFF);
+
+	// Like the firmware, button changes go out first in a compact report, the only one the OS reads buttons from.
+	uint8_t compactReport[3] = { REPORT_SENSOR_VALUES_COMPACT, report.buttonBits.bytes[0], report.buttonBits.bytes[1] };
+	if (memcmp(compactReport + 1, myCompactButtons, sizeof(myCompactButtons)) != 0)
+	{
+		memcpy(myCompactButtons, compactReport + 1, sizeof(myCompactButtons));
+		CountInputReport(reportTime);
+		return Reply(compactReport, data, length);
+	}
+
+	// Pending debug text takes at most every other report.
+	if (myDebugStream && !mySentDebugStream && !myDebugText.empty())
+	{
+		DebugStreamReport debugReport;
+		size_t size = min(myDebugText.size(), sizeof(debugReport.data));
+		memset(debugReport.data, 0, sizeof(debugReport.data));
+		memcpy(debugReport.data, myDebugText.data(), size);
+		debugReport.length = (uint8_t)size;
+		myDebugText.erase(0, size);
+		mySentDebugStream = true;
+		return Reply(debugReport, data, length);
+	}
+	mySentDebugStream = false;
+
+	CountInputReport(reportTime);
+
+	// Without the analog stream, the firmware only sends the buttons.
+	if (!myAnalogStream)
+		return Reply(compactReport, data, length);
+
+	if (myInputTiming)
+	{
+		SensorValuesTimedReport timedReport;
+		timedReport.buttonBits = report.buttonBits;
+		memcpy(timedReport.sensorValues, report.sensorValues, sizeof(timedReport.sensorValues));
+		timedReport.reportTime = WriteU32LE(reportMicros);
+		for (int i = 0; i < MAX_BUTTON_COUNT; ++i)
+			timedReport.buttonChangeTimes[i] = WriteU16LE(myButtonChangeTimes[i]);
+		return Reply(timedReport, data, length);
+	}
+
+	return Reply(report, data, length);
+}
+
+bool PadEmulator::NextSyntheticReport(SensorValuesReport& report, int timeoutMs)
+{
+	auto now = steady_clock::now();
+
+	// Like a device, wait for the next report up to the timeout. A negative timeout waits until it is there.
+	if (myNextReport > now)
+	{
+		if (timeoutMs == 0)
+			return false;
+
+		auto wakeup = myNextReport;
+		if (timeoutMs > 0)
+			wakeup = min(wakeup, now + milliseconds(timeoutMs));
+
+		this_thread::sleep_until(wakeup);
+		now = steady_clock::now();
+		if (myNextReport > now)
+			return false;
+	}
+
+	// Reports that were created while nobody was reading come out one by one, up to the size of the host buffer.
+	auto backlog = (now - myNextReport) / myReportInterval;
+	if (backlog >= HOST_REPORT_BUFFER_SIZE)
+		myNextReport += (backlog - HOST_REPORT_BUFFER_SIZE + 1) * myReportInterval;
+
+	double time = duration<double>(myNextReport - myStartTime).count();
+	myNextReport += myReportInterval;
+
+	report = SensorValuesReport();
+	for (int i = 0; i < mySettings.numSensors; ++i)
+		report.sensorValues[i] = WriteU16LE(SyntheticSensorValue(i, time, myNoiseRandom));
+
+	return true;
+}
+
+void PadEmulator::UpdateButtons(SensorValuesReport& report, uint16_t scanTime)
+{
+	// Same as the firmware: a pressed button stays pressed until all its sensors drop below the release threshold.
+	uint16_t buttonBits = 0;
+	for (int i = 0; i < mySettings.numSensors; ++i)
+	{
+		auto sensor = SensorAt(i);
+		int button = sensor.buttonMapping;
+		if (button < 0 || button >= mySettings.numButtons)
+			continue;
+
+		bool wasPressed = (myButtonBits & (1 << button)) != 0;
+		int threshold = ReadU16LE(wasPressed ? sensor.releaseThreshold : sensor.threshold);
+		if (ReadU16LE(report.sensorValues[i]) > threshold)
+			buttonBits |= (uint16_t)(1 << button);
+	}
+
+	for (int i = 0; i < MAX_BUTTON_COUNT; ++i)
+	{
+		if ((buttonBits ^ myButtonBits) & (1 << i))
+			myButtonChangeTimes[i] = scanTime;
+	}
+
+	myButtonBits = buttonBits;
+	report.buttonBits = WriteU16LE(buttonBits);
+}
+
+void PadEmulator::CountInputReport(steady_clock::time_point time)
+{
+	++myReportsInWindow;
+	if (time >= myWindowStart + seconds(1))
+	{
+		myReportRate = myReportsInWindow;
+		myPadUpdateAverageUs = myReportsInWindow ? min(myPadUpdateTotalUs / myReportsInWindow, 0xFFFF) : 0;
+		myReportsInWindow = 0;
+		myPadUpdateTotalUs = 0;
+		myWindowStart = time;
+	}
+}
+
+}; // namespace adp.
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Model/Reporter.h"
+
+namespace adp {
+
+class CaptureReplay;
+
+struct EmulatorSettings
+{
+	int numSensors = 4;
+	int numButtons = 4;
+	int numLeds = 0;
+
+	// Input reports per second. Full speed pads report at 1000 Hz, high speed pads at up to 8000 Hz.
+	int reportRate = 1000;
+
+	// Every feature report transfer takes the latency, plus or minus a random part of the jitter.
+	int latencyUs = 250;
+	int jitterUs = 100;
+
+	static constexpr int MIN_REPORT_RATE = 1000;
+	static constexpr int MAX_REPORT_RATE = 8000;
+};
+
+// Simulates a pad running the current firmware, for testing without hardware. It keeps the same configuration as the
+// firmware and answers every report like the firmware does. Sensor values are synthetic presses, or come from a
+// capture. Either way, buttons are derived from the emulated thresholds, so changing them has the expected effect.
+class PadEmulator
+{
+public:
+	PadEmulator(const EmulatorSettings& settings);
+
+	// Plays back the sensor values of a capture, and identifies as the pad the capture was recorded from.
+	PadEmulator(const EmulatorSettings& settings, std::unique_ptr<CaptureReplay> replay);
+
+	~PadEmulator();
+
+	// These behave like their hidapi counterparts. The first byte of the data is the report id.
+	int GetFeatureReport(uint8_t* data, size_t length);
+	int SendFeatureReport(const uint8_t* data, size_t length);
+	int Write(const uint8_t* data, size_t length);
+	int Read(uint8_t* data, size_t length, int timeoutMs);
+
+private:
+	void FactoryDefaults();
+	void WaitForTransfer();
+	bool NextSyntheticReport(SensorValuesReport& report, int timeoutMs);
+	void UpdateButtons(SensorValuesReport& report, uint16_t scanTime);
+	void CountInputReport(std::chrono::steady_clock::time_point time);
+	SensorReport SensorAt(int sensorIndex) const;
+
+	EmulatorSettings mySettings;
+	std::unique_ptr<CaptureReplay> myReplay;
+	IdentificationV2Report myIdentification;
+
+	// The configuration and statistics are shared between the reader thread and the thread doing feature transfers.
+	std::mutex myMutex;
+	NameReport myName;
+	std::vector<uint8_t> myConfigBlock;
+	std::vector<uint8_t> mySavedConfigBlock;
+	int mySelectedSensor = 0;
+	int mySelectedLightRule = 0;
+	int mySelectedLedMapping = 0;
+	size_t myConfigBlockOffset = 0;
+	bool myAnalogStream = false;
+	bool myInputTiming = false;
+	bool myDebugStream = false;
+	bool myIsDisconnected = false;
+	std::string myDebugText;
+	std::minstd_rand myJitterRandom;
+	std::chrono::steady_clock::time_point myWindowStart;
+	int myReportsInWindow = 0;
+	int myReportRate = 0;
+	int myPadUpdateTotalUs = 0; // in the current window.
+	int myPadUpdateAverageUs = 0;
+	int myPadUpdateMaxUs = 0;
+
+	// Only used by the reader thread.
+	uint16_t myButtonBits = 0;
+	bool mySentDebugStream = false;
+	uint8_t myCompactButtons[2] = {};
+	uint16_t myButtonChangeTimes[MAX_BUTTON_COUNT] = {};
+	std::minstd_rand myNoiseRandom;
+	std::chrono::steady_clock::time_point myStartTime;
+	std::chrono::steady_clock::time_point myNextReport;
+	std::chrono::steady_clock::duration myReportInterval;
+};
+
+}; // namespace adp.
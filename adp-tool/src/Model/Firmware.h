@@ -10,21 +10,14 @@
 #include <nlohmann/json.hpp>
 using json = nlohmann::json;
 
+#include "Model/Board.h"
+
 using namespace std;
 using namespace Slic3r;
 using namespace serial;
 
 namespace adp {
 
-enum BoardType {
-	BOARD_UNKNOWN,
-	BOARD_FSRMINIPAD,
-	BOARD_FSRMINIPAD_V2,
-	BOARD_TEENSY2,
-	BOARD_LEONARDO,
-	BOARD_FSRIO_V1
-};
-
 enum FlashResult
 {
 	FLASHRESULT_NOTHING,
@@ -71,8 +64,4 @@ private:
 };
 
 
-enum BoardType ParseBoardType(const std::string& str);
-const wchar_t* BoardTypeToString(BoardType boardType);
-const wchar_t* BoardTypeToString(BoardType boardType, bool firmwareFile);
-
 }; // namespace adp.
@@ -0,0 +1,121 @@
+#include "Adp.h"
+
+#include <cstdio>
+#include <cstring>
+
+#if defined(__linux__)
+#include <libudev.h>
+#include <poll.h>
+#endif
+
+#include "Model/Hotplug.h"
+#include "Model/Log.h"
+
+using namespace std;
+using namespace chrono;
+
+namespace adp {
+
+// Without hotplug notifications, this is how often the device list is enumerated.
+constexpr int FALLBACK_CHECK_INTERVAL_MS = 1000;
+
+#if defined(__linux__)
+
+// A hidraw device has no ids itself, they are in the HID_ID property of its hid parent as "bus:vendor:product".
+static bool ReadHidIds(udev_device* device, int& vendorId, int& productId)
+{
+	auto parent = udev_device_get_parent_with_subsystem_devtype(device, "hid", nullptr);
+	auto hidId = parent ? udev_device_get_property_value(parent, "HID_ID") : nullptr;
+
+	unsigned int bus, vendor, product;
+	if (!hidId || sscanf(hidId, "%x:%x:%x", &bus, &vendor, &product) != 3)
+		return false;
+
+	vendorId = (int)vendor;
+	productId = (int)product;
+	return true;
+}
+
+#endif
+
+HotplugWatcher::HotplugWatcher(CompatibilityCheck isCompatible)
+	: myIsCompatible(isCompatible)
+{
+#if defined(__linux__)
+	myUdev = udev_new();
+	if (myUdev)
+		myMonitor = udev_monitor_new_from_netlink(myUdev, "udev");
+
+	if (myMonitor && (udev_monitor_filter_add_match_subsystem_devtype(myMonitor, "hidraw", nullptr) < 0 ||
+		udev_monitor_enable_receiving(myMonitor) < 0))
+	{
+		udev_monitor_unref(myMonitor);
+		myMonitor = nullptr;
+	}
+
+	if (!myMonitor)
+		Log::Write(L"HotplugWatcher :: udev monitor unavailable, falling back to periodic enumeration");
+#endif
+}
+
+HotplugWatcher::~HotplugWatcher()
+{
+#if defined(__linux__)
+	if (myMonitor)
+		udev_monitor_unref(myMonitor);
+
+	if (myUdev)
+		udev_unref(myUdev);
+#endif
+}
+
+bool HotplugWatcher::PollChanges(vector<string>& changedPaths)
+{
+	bool check = myCheckRequested;
+	myCheckRequested = false;
+
+#if defined(__linux__)
+	if (myMonitor)
+	{
+		pollfd fd = { udev_monitor_get_fd(myMonitor), POLLIN, 0 };
+		while (poll(&fd, 1, 0) > 0 && (fd.revents & POLLIN))
+		{
+			auto device = udev_monitor_receive_device(myMonitor);
+			if (!device)
+				break;
+
+			auto action = udev_device_get_action(device);
+			auto path = udev_device_get_devnode(device);
+			int vendorId, productId;
+
+			// Unplugged devices can no longer be identified, so every removal is passed on. It only matters for
+			// paths that are known. Plugged in devices only cause an enumeration if they are compatible.
+			if (action && path && strcmp(action, "remove") == 0)
+			{
+				changedPaths.push_back(path);
+			}
+			else if (action && path && strcmp(action, "add") == 0 &&
+				ReadHidIds(device, vendorId, productId) && myIsCompatible(vendorId, productId))
+			{
+				changedPaths.push_back(path);
+				check = true;
+			}
+
+			udev_device_unref(device);
+		}
+
+		return check;
+	}
+#endif
+
+	auto now = steady_clock::now();
+	if (check || now >= myNextCheck)
+	{
+		myNextCheck = now + milliseconds(FALLBACK_CHECK_INTERVAL_MS);
+		return true;
+	}
+
+	return false;
+}
+
+}; // namespace adp.
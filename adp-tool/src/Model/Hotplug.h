@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+
+struct udev;
+struct udev_monitor;
+
+namespace adp {
+
+// Tells the connection manager when it is worth enumerating HID devices. On Linux, this listens to udev for hidraw
+// devices being added or removed. Elsewhere, or if udev is not available, it falls back to a limited enumeration rate.
+class HotplugWatcher
+{
+public:
+	typedef bool (*CompatibilityCheck)(int vendorId, int productId);
+
+	HotplugWatcher(CompatibilityCheck isCompatible);
+	~HotplugWatcher();
+
+	// Returns true if the device list should be enumerated. With notifications, the paths of devices that were plugged
+	// in or unplugged since the previous call are added to changedPaths.
+	bool PollChanges(std::vector<std::string>& changedPaths);
+
+	// Makes the next call to PollChanges return true.
+	void RequestCheck() { myCheckRequested = true; }
+
+	// True if devices are reported as they are plugged in, in which case udev rules have already run for them.
+	bool HasNotifications() const { return myMonitor != nullptr; }
+
+private:
+	CompatibilityCheck myIsCompatible;
+	bool myCheckRequested = true;
+	std::chrono::time_point<std::chrono::steady_clock> myNextCheck;
+	struct udev* myUdev = nullptr;
+	struct udev_monitor* myMonitor = nullptr;
+};
+
+}; // namespace adp.
@@ -0,0 +1,162 @@
+#include "Adp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "Model/LatencyStats.h"
+#include "Model/Log.h"
+
+using namespace std;
+using namespace chrono;
+
+namespace adp {
+
+// About a minute of reports at 1 kHz.
+constexpr size_t LATENCY_WINDOW_SIZE = 65536;
+
+// ====================================================================================================================
+// Helper functions.
+// ====================================================================================================================
+
+// Nearest-rank percentile, the values are partially reordered.
+static double Percentile(vector<uint32_t>& values, double fraction)
+{
+	size_t rank = (size_t)ceil(fraction * values.size());
+	auto nth = values.begin() + (max(rank, (size_t)1) - 1);
+	nth_element(values.begin(), nth, values.end());
+	return *nth;
+}
+
+static LatencyDistribution Distribution(vector<uint32_t>& values)
+{
+	LatencyDistribution result;
+	if (values.empty())
+		return result;
+
+	result.count = (int)values.size();
+	result.max = *max_element(values.begin(), values.end());
+	result.p99 = Percentile(values, 0.99);
+	result.p50 = Percentile(values, 0.5);
+	return result;
+}
+
+// ====================================================================================================================
+// Latency stats.
+// ====================================================================================================================
+
+void LatencyStats::Window::Add(uint32_t value)
+{
+	if (values.size() < LATENCY_WINDOW_SIZE)
+	{
+		values.push_back(value);
+	}
+	else
+	{
+		values[next] = value;
+		next = (next + 1) % LATENCY_WINDOW_SIZE;
+	}
+}
+
+void LatencyStats::Window::Clear()
+{
+	values.clear();
+	next = 0;
+}
+
+void LatencyStats::Add(steady_clock::time_point received, const SensorValuesReport& report, const InputTiming& timing)
+{
+	if (!timing.valid)
+	{
+		myHasPrevious = false;
+		return;
+	}
+
+	uint16_t buttons = (uint16_t)ReadU16LE(report.buttonBits);
+	if (myHasPrevious)
+	{
+		// The pad clock wraps around, unsigned differences are still correct across the wrap.
+		myReportIntervals.Add(timing.reportTime - myPreviousReportTime);
+		myHostIntervals.Add((uint32_t)duration_cast<microseconds>(received - myPreviousReceived).count());
+
+		uint16_t changed = buttons ^ myPreviousButtons;
+		for (int i = 0; i < MAX_BUTTON_COUNT; ++i)
+		{
+			if ((changed & (1 << i)) && timing.buttonChangeTimes[i] != myPreviousChangeTimes[i])
+				myPressLatencies.Add((uint16_t)((uint16_t)timing.reportTime - timing.buttonChangeTimes[i]));
+		}
+	}
+
+	myHasPrevious = true;
+	myPreviousReceived = received;
+	myPreviousReportTime = timing.reportTime;
+	myPreviousButtons = buttons;
+	copy(begin(timing.buttonChangeTimes), end(timing.buttonChangeTimes), myPreviousChangeTimes);
+}
+
+void LatencyStats::Reset()
+{
+	myPressLatencies.Clear();
+	myReportIntervals.Clear();
+	myHostIntervals.Clear();
+	myHasPrevious = false;
+}
+
+LatencySummary LatencyStats::Summarize() const
+{
+	LatencySummary result;
+
+	auto values = myPressLatencies.values;
+	result.pressLatency = Distribution(values);
+
+	values = myHostIntervals.values;
+	result.hostInterval = Distribution(values);
+
+	values = myReportIntervals.values;
+	result.reportInterval = Distribution(values);
+
+	auto median = (uint32_t)result.reportInterval.p50;
+	for (auto& value : values)
+		value = (value > median) ? (value - median) : (median - value);
+	result.reportJitter = Distribution(values);
+
+	return result;
+}
+
+bool LatencyStats::Export(const char* path, const string& label, const LatencySummary& summary)
+{
+	auto file = fopen(path, "r");
+	bool isNew = (file == nullptr);
+	if (file)
+		fclose(file);
+
+	file = fopen(path, "a");
+	if (!file)
+	{
+		Log::Writef(L"LatencyStats :: could not open %hs", path);
+		return false;
+	}
+
+	if (isNew)
+		fprintf(file, "pad,metric,count,p50_us,p99_us,max_us\n");
+
+	auto WriteRow = [&](const char* metric, const LatencyDistribution& d)
+	{
+		fprintf(file, "\"%s\",%s,%i,%.0f,%.0f,%.0f\n", label.c_str(), metric, d.count, d.p50, d.p99, d.max);
+	};
+	WriteRow("press_latency", summary.pressLatency);
+	WriteRow("report_interval", summary.reportInterval);
+	WriteRow("report_jitter", summary.reportJitter);
+	WriteRow("host_interval", summary.hostInterval);
+
+	bool success = (ferror(file) == 0);
+	fclose(file);
+
+	if (success)
+		Log::Writef(L"LatencyStats :: exported to %hs", path);
+	else
+		Log::Writef(L"LatencyStats :: write to %hs failed", path);
+	return success;
+}
+
+}; // namespace adp.
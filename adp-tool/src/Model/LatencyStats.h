@@ -0,0 +1,73 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "Model/Reporter.h"
+
+namespace adp {
+
+// Percentiles of a set of durations, in microseconds.
+struct LatencyDistribution
+{
+	int count = 0;
+	double p50 = 0.0;
+	double p99 = 0.0;
+	double max = 0.0;
+};
+
+struct LatencySummary
+{
+	// From a button crossing its threshold on the pad to the report with the change being handed to USB.
+	LatencyDistribution pressLatency;
+
+	// Time between consecutive input reports, on the pad clock.
+	LatencyDistribution reportInterval;
+
+	// How far report intervals deviate from their median.
+	LatencyDistribution reportJitter;
+
+	// Time between consecutive input reports, as received by the host.
+	LatencyDistribution hostInterval;
+};
+
+// Collects timing of the input reports of a pad, from the timestamps in timed sensor value reports. Only the most
+// recent measurements are kept, so the distributions follow changes in the configuration.
+class LatencyStats
+{
+public:
+	void Add(std::chrono::steady_clock::time_point received, const SensorValuesReport& report, const InputTiming& timing);
+	void Reset();
+
+	bool IsEmpty() const { return myReportIntervals.values.empty(); }
+
+	LatencySummary Summarize() const;
+
+	// Appends the summary to a CSV file, so the results of several firmware builds end up side by side.
+	// The label identifies the pad and firmware the measurements were taken from.
+	static bool Export(const char* path, const std::string& label, const LatencySummary& summary);
+
+private:
+	// Holds the most recent values, older values are overwritten.
+	struct Window
+	{
+		void Add(uint32_t value);
+		void Clear();
+
+		std::vector<uint32_t> values;
+		size_t next = 0;
+	};
+
+	Window myPressLatencies;
+	Window myReportIntervals;
+	Window myHostIntervals;
+
+	bool myHasPrevious = false;
+	std::chrono::steady_clock::time_point myPreviousReceived;
+	uint32_t myPreviousReportTime = 0;
+	uint16_t myPreviousButtons = 0;
+	uint16_t myPreviousChangeTimes[MAX_BUTTON_COUNT] = {};
+};
+
+}; // namespace adp.
@@ -1,55 +1,314 @@
 #include "Adp.h"
 
-#include <stdarg.h>
-#include <stdio.h>
-#include <vector>
-#include <memory>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
 #include <string>
+#include <thread>
 
-#include "Log.h"
+#include "Model/Log.h"
+#include "Model/Utils.h"
 
 using namespace std;
+using namespace chrono;
 
 namespace adp {
 
-static vector<wstring>* messages = nullptr;
+// Number of records in the ring, must be a power of two.
+constexpr size_t RING_SIZE = 4096;
+
+// Number of formatted messages that are kept for display.
+constexpr size_t HISTORY_SIZE = 10000;
+
+// How long the log thread waits before it looks for new messages again.
+constexpr auto DRAIN_INTERVAL = milliseconds(10);
+
+// A slot in the ring. The sequence tells whose turn it is: it equals the position of the slot when a writer can claim
+// it, and the position plus one when it holds a message for the reader (see Vyukov's bounded queue).
+struct LogRecord
+{
+	atomic<size_t> sequence;
+	size_t position;
+	LogLevel level;
+	steady_clock::time_point time;
+	const wchar_t* format;
+	LogFormatFunction formatter;
+	alignas(8) uint8_t args[Log::MAX_ARGS_SIZE];
+};
+
+static LogRecord* ring = nullptr;
+static atomic<size_t> enqueuePosition = 0;
+static size_t dequeuePosition = 0;
+static atomic<size_t> numDropped = 0;
+static atomic<int> minLevel = LOG_INFO;
+static steady_clock::time_point startTime;
+
+// Formatting and everything after it is done by one thread at a time, usually the log thread.
+static mutex drainMutex;
+static FILE* file = nullptr;
+
+// The formatted messages, read by the views.
+static mutex historyMutex;
+static deque<LogMessage> history;
+static uint64_t nextIndex = 0;
+
+static thread logThread;
+static mutex wakeMutex;
+static condition_variable wakeCondition;
+static bool stopping = false;
+
+static void TakeText(const wchar_t*, const uint8_t* args, wstring& out)
+{
+	wstring* text;
+	memcpy(&text, args, sizeof(text));
+	out = move(*text);
+	delete text;
+}
+
+static void Append(LogLevel level, steady_clock::time_point time, wstring& text)
+{
+	LogMessage message;
+	message.level = level;
+	message.time = duration<double>(time - startTime).count();
+
+	if (file)
+	{
+		auto narrowText = narrow(text.data(), text.size());
+		fprintf(file, "%10.3f %-7s %s\n", message.time, Log::LevelName(level), narrowText.c_str());
+	}
+
+	message.text = move(text);
+
+	lock_guard<mutex> lock(historyMutex);
+	message.index = nextIndex++;
+	history.push_back(move(message));
+	if (history.size() > HISTORY_SIZE)
+		history.pop_front();
+}
+
+static void Drain()
+{
+	lock_guard<mutex> lock(drainMutex);
+	if (!ring)
+		return;
+
+	bool appended = false;
+	for (;; ++dequeuePosition)
+	{
+		LogRecord& record = ring[dequeuePosition & (RING_SIZE - 1)];
+		if (record.sequence.load(memory_order_acquire) != dequeuePosition + 1)
+			break;
+
+		wstring text;
+		record.formatter(record.format, record.args, text);
+		auto level = record.level;
+		auto time = record.time;
+
+		// From here on, the record can be claimed by a writer again.
+		record.sequence.store(dequeuePosition + RING_SIZE, memory_order_release);
+
+		Append(level, time, text);
+		appended = true;
+	}
+
+	size_t dropped = numDropped.exchange(0);
+	if (dropped > 0)
+	{
+		wstring text = L"Log :: " + to_wstring(dropped) + L" messages dropped";
+		Append(LOG_WARNING, steady_clock::now(), text);
+		appended = true;
+	}
+
+	if (appended && file)
+		fflush(file);
+}
+
+static void LogThread()
+{
+	unique_lock<mutex> lock(wakeMutex);
+	while (!stopping)
+	{
+		lock.unlock();
+		Drain();
+		lock.lock();
+		wakeCondition.wait_for(lock, DRAIN_INTERVAL, [] { return stopping; });
+	}
+	lock.unlock();
+	Drain();
+}
+
+// ====================================================================================================================
+// Log.
+// ====================================================================================================================
 
 void Log::Init()
 {
-	messages = new vector<wstring>();
+	ring = new LogRecord[RING_SIZE];
+	for (size_t i = 0; i < RING_SIZE; ++i)
+		ring[i].sequence.store(i, memory_order_relaxed);
+
+	enqueuePosition = 0;
+	dequeuePosition = 0;
+	startTime = steady_clock::now();
+
+	stopping = false;
+	logThread = thread(LogThread);
 }
 
 void Log::Shutdown()
 {
-	delete messages;
-	messages = nullptr;
+	{
+		lock_guard<mutex> lock(wakeMutex);
+		stopping = true;
+	}
+	wakeCondition.notify_one();
+	if (logThread.joinable())
+		logThread.join();
+
+	SetFile("");
+
+	lock_guard<mutex> lock(drainMutex);
+	delete[] ring;
+	ring = nullptr;
+}
+
+bool Log::SetFile(const char* path)
+{
+	Drain();
+
+	lock_guard<mutex> lock(drainMutex);
+	if (file)
+	{
+		fclose(file);
+		file = nullptr;
+	}
+
+	if (!path || !path[0])
+		return true;
+
+	file = fopen(path, "w");
+	return file != nullptr;
+}
+
+void Log::SetLevel(LogLevel level)
+{
+	minLevel.store(level, memory_order_relaxed);
+}
+
+bool Log::IsEnabled(LogLevel level)
+{
+	return level >= ADP_LOG_MIN_LEVEL && level >= minLevel.load(memory_order_relaxed);
 }
 
 void Log::Write(const wchar_t* message)
 {
-	messages->emplace_back(message);
+	Post(LOG_INFO, L"%ls", message);
+}
+
+bool Log::Read(uint64_t& index, LogMessage& message)
+{
+	lock_guard<mutex> lock(historyMutex);
+	if (history.empty() || index >= nextIndex)
+		return false;
+
+	index = max(index, history.front().index);
+	message = history[index - history.front().index];
+	++index;
+	return true;
 }
 
-void Log::Writef(const wchar_t* format, ...)
+bool Log::Message(uint64_t index, LogMessage& message)
 {
-	wchar_t buffer[256];
-	va_list args;
-	va_start(args, format);
+	lock_guard<mutex> lock(historyMutex);
+	if (history.empty() || index < history.front().index || index >= nextIndex)
+		return false;
 
-	size_t len = vswprintf(buffer, 256, format, args);
-	messages->emplace_back((const wchar_t*)buffer, len);
-	
-	va_end (args);
+	message = history[index - history.front().index];
+	return true;
 }
 
-int Log::NumMessages()
+uint64_t Log::FirstIndex()
 {
-	return (int)messages->size();
+	lock_guard<mutex> lock(historyMutex);
+	return history.empty() ? nextIndex : history.front().index;
 }
 
-const wstring& Log::Message(int index)
+const char* Log::LevelName(LogLevel level)
 {
-	return messages->at(index);
+	switch (level)
+	{
+	case LOG_DEBUG: return "debug";
+	case LOG_INFO: return "info";
+	case LOG_WARNING: return "warning";
+	case LOG_ERROR: return "error";
+	}
+	return "";
+}
+
+void Log::Flush()
+{
+	Drain();
+}
+
+LogRecord* Log::Claim(LogLevel level, const wchar_t* format, LogFormatFunction formatter)
+{
+	if (!ring)
+		return nullptr;
+
+	size_t position = enqueuePosition.load(memory_order_relaxed);
+	for (;;)
+	{
+		LogRecord& record = ring[position & (RING_SIZE - 1)];
+		auto difference = (intptr_t)record.sequence.load(memory_order_acquire) - (intptr_t)position;
+		if (difference == 0)
+		{
+			if (enqueuePosition.compare_exchange_weak(position, position + 1, memory_order_relaxed))
+			{
+				record.position = position;
+				record.level = level;
+				record.time = steady_clock::now();
+				record.format = format;
+				record.formatter = formatter;
+				return &record;
+			}
+		}
+		else if (difference < 0)
+		{
+			// The reader did not get to this record yet, the ring is full.
+			numDropped.fetch_add(1, memory_order_relaxed);
+			return nullptr;
+		}
+		else
+		{
+			position = enqueuePosition.load(memory_order_relaxed);
+		}
+	}
+}
+
+uint8_t* Log::RecordArgs(LogRecord* record)
+{
+	return record->args;
+}
+
+void Log::Publish(LogRecord* record)
+{
+	record->sequence.store(record->position + 1, memory_order_release);
+}
+
+void Log::PostText(LogLevel level, wstring* text)
+{
+	LogRecord* record = Claim(level, nullptr, &TakeText);
+	if (!record)
+	{
+		delete text;
+		return;
+	}
+
+	memcpy(record->args, &text, sizeof(text));
+	Publish(record);
 }
 
 }; // namespace adp.
@@ -1,23 +1,206 @@
 #pragma once
 
+#include <cstdint>
+#include <cstring>
+#include <cwchar>
 #include <string>
+#include <tuple>
+#include <type_traits>
+
+// Messages below this level are compiled out entirely, see LogLevel. Release builds leave out debug messages.
+#ifndef ADP_LOG_MIN_LEVEL
+#define ADP_LOG_MIN_LEVEL 0
+#endif
 
 namespace adp {
 
+enum LogLevel
+{
+	LOG_DEBUG = 0,
+	LOG_INFO = 1,
+	LOG_WARNING = 2,
+	LOG_ERROR = 3,
+};
+
+struct LogMessage
+{
+	uint64_t index;
+	LogLevel level;
+	double time; // Seconds since Log::Init.
+	std::wstring text;
+};
+
+using LogFormatFunction = void (*)(const wchar_t* format, const uint8_t* args, std::wstring& out);
+
+struct LogRecord;
+
+// Messages are written to a fixed-size ring of records without taking a lock or allocating, so any thread can log,
+// including the device reader threads. The format string must be a literal, since only a pointer to it is stored.
+// The arguments are copied into the record as they are and only formatted later, on the log thread. That thread also
+// writes the messages to the log file, if there is one, and keeps the most recent messages for display. When the ring
+// is full, messages are dropped and the number of dropped messages is logged once there is room again.
 class Log
 {
 public:
+	// Bytes available for the arguments of a message in a record. Messages with more are formatted right away.
+	static constexpr size_t MAX_ARGS_SIZE = 480;
+
+	static constexpr size_t MAX_MESSAGE_LENGTH = 64 * 1024;
+
 	static void Init();
 
 	static void Shutdown();
 
+	// Also writes every message to the given file, returns false if it could not be opened. An empty path closes it.
+	static bool SetFile(const char* path);
+
+	// Messages below the given level are ignored. The default is LOG_INFO.
+	static void SetLevel(LogLevel level);
+
+	static bool IsEnabled(LogLevel level);
+
 	static void Write(const wchar_t* message);
 
-	static void Writef(const wchar_t* format, ...);
+	template <typename... Args>
+	static void Writef(const wchar_t* format, Args... args) { Post(LOG_INFO, format, args...); }
+
+	template <typename... Args>
+	static void Debugf(const wchar_t* format, Args... args)
+	{
+		if constexpr (ADP_LOG_MIN_LEVEL <= LOG_DEBUG)
+			Post(LOG_DEBUG, format, args...);
+	}
+
+	template <typename... Args>
+	static void Warningf(const wchar_t* format, Args... args) { Post(LOG_WARNING, format, args...); }
+
+	template <typename... Args>
+	static void Errorf(const wchar_t* format, Args... args) { Post(LOG_ERROR, format, args...); }
+
+	// Reads the message with the given index and advances the index, returns false if there is no such message yet.
+	// Only the most recent messages are kept, an index of a message that is gone skips ahead to the oldest one kept.
+	static bool Read(uint64_t& index, LogMessage& message);
+
+	// Reads the message with the given index without advancing, returns false if it is not kept or not there yet.
+	static bool Message(uint64_t index, LogMessage& message);
+
+	// Index of the oldest message that is kept.
+	static uint64_t FirstIndex();
+
+	static const char* LevelName(LogLevel level);
+
+	// Waits until all messages written so far can be read.
+	static void Flush();
+
+private:
+	// Arguments are stored in the record as their promoted type, strings are stored as a length and the characters.
+	template <typename T, typename Enable = void>
+	struct Arg
+	{
+		static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>, "unsupported log argument");
+
+		using Stored = std::conditional_t<std::is_enum_v<T>, int, decltype(+std::declval<T>())>;
+
+		static size_t Size(T) { return sizeof(Stored); }
+		static void Put(uint8_t*& out, T value) { Stored stored = (Stored)value; memcpy(out, &stored, sizeof(Stored)); out += sizeof(Stored); }
+		static Stored Get(const uint8_t*& in) { Stored stored; memcpy(&stored, in, sizeof(Stored)); in += sizeof(Stored); return stored; }
+	};
+
+	template <typename C>
+	struct StringArg
+	{
+		using Stored = const C*;
+
+		static size_t Length(const C* value) { return value ? std::char_traits<C>::length(value) : 0; }
+		static size_t Size(const C* value) { return sizeof(uint32_t) + (Length(value) + 1) * sizeof(C); }
+		static void Put(uint8_t*& out, const C* value)
+		{
+			uint32_t length = (uint32_t)Length(value);
+			memcpy(out, &length, sizeof(uint32_t));
+			out += sizeof(uint32_t);
+			if (length > 0)
+				memcpy(out, value, length * sizeof(C));
+			memset(out + length * sizeof(C), 0, sizeof(C));
+			out += (length + 1) * sizeof(C);
+		}
+		static Stored Get(const uint8_t*& in)
+		{
+			uint32_t length;
+			memcpy(&length, in, sizeof(uint32_t));
+			auto value = (const C*)(in + sizeof(uint32_t));
+			in += sizeof(uint32_t) + (length + 1) * sizeof(C);
+			return value;
+		}
+	};
+
+	template <typename T>
+	struct Arg<T, std::enable_if_t<std::is_same_v<std::decay_t<T>, const char*> || std::is_same_v<std::decay_t<T>, char*>>>
+		: StringArg<char> {};
+
+	template <typename T>
+	struct Arg<T, std::enable_if_t<std::is_same_v<std::decay_t<T>, const wchar_t*> || std::is_same_v<std::decay_t<T>, wchar_t*>>>
+		: StringArg<wchar_t> {};
+
+	// Turns the stored arguments back into values and formats them. There is one of these for every argument list.
+	template <typename... Args>
+	static void Format(const wchar_t* format, const uint8_t* in, std::wstring& out)
+	{
+		// Arguments in a braced list are evaluated in order, so they are read back in the order they were stored.
+		std::tuple<typename Arg<Args>::Stored...> values{ Arg<Args>::Get(in)... };
+		std::apply([&](auto... value) { FormatValues(out, format, value...); }, values);
+	}
+
+	template <typename... Values>
+	static void FormatValues(std::wstring& out, const wchar_t* format, Values... values)
+	{
+		out.resize(256);
+		for (;;)
+		{
+			int length = swprintf(&out[0], out.size(), format, values...);
+			if (length >= 0 && (size_t)length < out.size())
+			{
+				out.resize(length);
+				return;
+			}
+			if (out.size() >= MAX_MESSAGE_LENGTH)
+			{
+				out = L"Log :: message could not be formatted";
+				return;
+			}
+			out.resize(out.size() * 4);
+		}
+	}
+
+	template <typename... Args>
+	static void Post(LogLevel level, const wchar_t* format, Args... args)
+	{
+		if (!IsEnabled(level))
+			return;
+
+		size_t size = (Arg<Args>::Size(args) + ... + 0);
+		if (size > MAX_ARGS_SIZE)
+		{
+			// Rare, like the debug output of a pad. These are formatted right away and the text is handed over.
+			auto text = new std::wstring;
+			FormatValues(*text, format, static_cast<typename Arg<Args>::Stored>(args)...);
+			PostText(level, text);
+			return;
+		}
 
-	static int NumMessages();
+		LogRecord* record = Claim(level, format, &Format<Args...>);
+		if (record)
+		{
+			[[maybe_unused]] uint8_t* out = RecordArgs(record);
+			(Arg<Args>::Put(out, args), ...);
+			Publish(record);
+		}
+	}
 
-	static const std::wstring& Message(int index);
+	// Reserves the next record, returns null if the ring is full.
+	static LogRecord* Claim(LogLevel level, const wchar_t* format, LogFormatFunction formatter);
+	static uint8_t* RecordArgs(LogRecord* record);
+	static void Publish(LogRecord* record);
+	static void PostText(LogLevel level, std::wstring* text);
 };
 
-}; // namespace adp.
\ No newline at end of file
+}; // namespace adp.
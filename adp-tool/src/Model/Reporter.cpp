@@ -1,10 +1,12 @@
 #include "Adp.h"
 
+#include <algorithm>
 #include <cstring>
 #include <chrono>
 #include <thread>
 
 #include "Model/Reporter.h"
+#include "Model/Emulator.h"
 #include "Model/Log.h"
 #include "Model/Utils.h"
 
@@ -16,8 +18,40 @@ namespace adp {
 // Helper functions.
 // ====================================================================================================================
 
+// Transfers go to the pad, or to the emulator if the reporter has one.
+struct HidTarget
+{
+	hid_device* hid;
+	PadEmulator* emulator;
+
+	int GetFeatureReport(uint8_t* data, size_t length)
+	{
+		return emulator ? emulator->GetFeatureReport(data, length) : hid_get_feature_report(hid, data, length);
+	}
+
+	int SendFeatureReport(const uint8_t* data, size_t length)
+	{
+		return emulator ? emulator->SendFeatureReport(data, length) : hid_send_feature_report(hid, data, length);
+	}
+
+	int Write(const uint8_t* data, size_t length)
+	{
+		return emulator ? emulator->Write(data, length) : hid_write(hid, data, length);
+	}
+
+	int Read(uint8_t* data, size_t length, int timeoutMs)
+	{
+		return emulator ? emulator->Read(data, length, timeoutMs) : hid_read_timeout(hid, data, length, timeoutMs);
+	}
+
+	const wchar_t* Error()
+	{
+		return emulator ? L"emulated transfer failed" : hid_error(hid);
+	}
+};
+
 template <typename T>
-static bool GetFeatureReport(hid_device* hid, T& report, const wchar_t* name)
+static bool GetFeatureReport(HidTarget target, TransferPacing& pacing, T& report, const wchar_t* name)
 {
 	uint8_t buffer[MAX_REPORT_SIZE];
 	buffer[0] = report.reportId;
@@ -25,82 +59,161 @@ static bool GetFeatureReport(hid_device* hid, T& report, const wchar_t* name)
 	auto size = sizeof(T);
 	auto expectedSize = sizeof(T);
 
-	int bytesRead = hid_get_feature_report(hid, buffer, sizeof(buffer));
+	pacing.WaitForGap();
+	int bytesRead = target.GetFeatureReport(buffer, sizeof(buffer));
+	pacing.TransferDone(false, bytesRead == expectedSize);
 	if (bytesRead == expectedSize)
 	{
 		memcpy(&report, buffer, size);
-		Log::Writef(L"%ls :: done", name);
+		Log::Debugf(L"%ls :: done", name);
 		return true;
 	}
 
 	if (bytesRead < 0)
-		Log::Writef(L"%ls :: hid_get_feature_report failed (%ls)", name, hid_error(hid));
+		Log::Warningf(L"%ls :: hid_get_feature_report failed (%ls)", name, target.Error());
 	else
-		Log::Writef(L"%ls :: unexpected number of bytes read (%i) expected (%i)", name, bytesRead, expectedSize);
+		Log::Warningf(L"%ls :: unexpected number of bytes read (%i) expected (%i)", name, bytesRead, (int)expectedSize);
 	return false;
 }
 
 template <typename T>
-static bool SendFeatureReport(hid_device* hid, const T& report, const wchar_t* name)
+static bool SendFeatureReport(HidTarget target, TransferPacing& pacing, const T& report, const wchar_t* name)
 {
-	using namespace std::chrono_literals;
-
-	// Wait for the controller to get into a ready state
-	std::this_thread::sleep_for(2ms);
-
-	int bytesWritten = hid_send_feature_report(hid, (const unsigned char*)&report, sizeof(T));
+	pacing.WaitForGap();
+	int bytesWritten = target.SendFeatureReport((const uint8_t*)&report, sizeof(T));
+	pacing.TransferDone(true, bytesWritten == sizeof(T));
 	if (bytesWritten == sizeof(T))
 	{
-		Log::Writef(L"%ls :: done", name);
+		Log::Debugf(L"%ls :: done", name);
 		return true;
 	}
 
 	if (bytesWritten < 0)
-		Log::Writef(L"%ls :: hid_send_feature_report failed (%ls)", name, hid_error(hid));
+		Log::Warningf(L"%ls :: hid_send_feature_report failed (%ls)", name, target.Error());
 	else
-		Log::Writef(L"%ls :: unexpected number of bytes written (%i)", name, bytesWritten);
+		Log::Warningf(L"%ls :: unexpected number of bytes written (%i)", name, bytesWritten);
 	return false;
 }
 
-template <typename T>
-static ReadDataResult ReadData(hid_device* hid, T& report, const wchar_t* name)
+static ReadDataResult ReadData(HidTarget target, SensorValuesReport& report, InputTiming& timing, string* debugText, int timeoutMs, const wchar_t* name)
 {
 	uint8_t buffer[MAX_REPORT_SIZE];
 	buffer[0] = report.reportId;
 
-	int bytesRead = hid_read(hid, buffer, sizeof(buffer));
-	if (bytesRead == sizeof(SensorValuesReport))
+	// A negative timeout blocks until a report arrives, zero returns immediately.
+	int bytesRead = target.Read(buffer, sizeof(buffer), timeoutMs);
+
+	if (bytesRead == 0)
+		return ReadDataResult::NO_DATA;
+
+	if (bytesRead < 0)
+	{
+		Log::Warningf(L"%ls :: hid_read failed (%ls)", name, target.Error());
+		return ReadDataResult::FAILURE;
+	}
+
+	// Dispatch on the report ID and only require the report to be complete. Some platforms, like hidapi
+	// on Windows, pad every input report to the size of the largest one the device declares.
+	switch (buffer[0])
 	{
+	case REPORT_SENSOR_VALUES:
+		if (bytesRead < sizeof(SensorValuesReport))
+			break;
+
 		memcpy(&report, buffer, sizeof(SensorValuesReport));
+		timing.valid = false;
+		return ReadDataResult::SUCCESS;
+
+	case REPORT_SENSOR_VALUES_TIMED:
+	{
+		if (bytesRead < sizeof(SensorValuesTimedReport))
+			break;
+
+		SensorValuesTimedReport timed;
+		memcpy(&timed, buffer, sizeof(SensorValuesTimedReport));
+
+		report.buttonBits = timed.buttonBits;
+		memcpy(report.sensorValues, timed.sensorValues, sizeof(report.sensorValues));
+
+		timing.valid = true;
+		timing.reportTime = ReadU32LE(timed.reportTime);
+		for (int i = 0; i < MAX_BUTTON_COUNT; ++i)
+			timing.buttonChangeTimes[i] = (uint16_t)ReadU16LE(timed.buttonChangeTimes[i]);
 		return ReadDataResult::SUCCESS;
 	}
 
-	if (bytesRead == 0)
+	case REPORT_DEBUG_STREAM:
+	{
+		if (bytesRead < 2)
+			break;
+
+		size_t length = min<size_t>({ buffer[1], sizeof(DebugStreamReport::data), (size_t)bytesRead - 2 });
+		if (debugText)
+			debugText->append((const char*)buffer + 2, length);
 		return ReadDataResult::NO_DATA;
+	}
 
-	if (bytesRead < 0)
-		Log::Writef(L"%ls :: hid_read failed (%ls)", name, hid_error(hid));
-	else
-		Log::Writef(L"%ls :: unexpected number of bytes read (%i)", name, bytesRead);
+	case REPORT_SENSOR_VALUES_COMPACT:
+		if (bytesRead < 1 + sizeof(report.buttonBits))
+			break;
 
+		memcpy(&report.buttonBits, buffer + 1, sizeof(report.buttonBits));
+		timing.valid = false;
+		return ReadDataResult::BUTTONS_ONLY;
+
+	default:
+		// Other input reports carry nothing we need.
+		return ReadDataResult::NO_DATA;
+	}
+
+	Log::Warningf(L"%ls :: unexpected number of bytes read (%i)", name, bytesRead);
 	return ReadDataResult::FAILURE;
 }
 
-static bool WriteData(hid_device* hid, uint8_t reportId, const wchar_t* name, bool performErrorCheck)
+static bool WriteData(HidTarget target, TransferPacing& pacing, uint8_t reportId, const wchar_t* name, bool performErrorCheck)
 {
 	// Linux wants reports of at leats 2 bytes
 	uint8_t buf[2] = { reportId, 0 };
 
-	int bytesWritten = hid_write(hid, buf, sizeof(buf));
+	pacing.WaitForGap();
+	int bytesWritten = target.Write(buf, sizeof(buf));
+	pacing.TransferDone(true, bytesWritten > 0 || !performErrorCheck);
 	if (bytesWritten > 0 || !performErrorCheck)
 	{
-		Log::Writef(L"%ls :: done", name);
+		Log::Debugf(L"%ls :: done", name);
 		return true;
 	}
-	Log::Writef(L"%ls :: hid_write failed (%ls)", name, hid_error(hid));
+	Log::Warningf(L"%ls :: hid_write failed (%ls)", name, target.Error());
 	return false;
 }
 
+// ====================================================================================================================
+// Transfer pacing.
+// ====================================================================================================================
+
+constexpr chrono::microseconds TransferPacing::MIN_GAP;
+constexpr chrono::microseconds TransferPacing::MAX_GAP;
+
+void TransferPacing::WaitForGap()
+{
+	auto readyTime = myLastWrite + myGap;
+	auto now = chrono::steady_clock::now();
+	if (now < readyTime)
+		this_thread::sleep_for(readyTime - now);
+}
+
+void TransferPacing::TransferDone(bool isWrite, bool success)
+{
+	if (success)
+		myGap = max(MIN_GAP, myGap / 2);
+	else
+		myGap = min(MAX_GAP, myGap * 2);
+
+	// Reads do not need processing time on the pad, but a failed read is most likely a pad that is still busy.
+	if (isWrite || !success)
+		myLastWrite = chrono::steady_clock::now();
+}
+
 // ====================================================================================================================
 // Reporter.
 // ====================================================================================================================
@@ -110,179 +223,134 @@ Reporter::Reporter(hid_device* device)
 {
 }
 
-Reporter::Reporter()
+Reporter::Reporter(unique_ptr<PadEmulator> emulator)
+	: myHid(nullptr)
+	, myEmulator(move(emulator))
 {
-	emulator = true;
 }
 
 Reporter::~Reporter()
 {
-	if(!emulator) {
+	if (myHid) {
 		hid_close(myHid);
 	}
 }
 
+HidTarget Reporter::Target()
+{
+	return { myHid, myEmulator.get() };
+}
+
 ReadDataResult Reporter::Get(SensorValuesReport& report)
 {
-	if(emulator) {
-		return ReadDataResult::NO_DATA;
-	}
-	
-	return ReadData(myHid, report, L"GetSensorValuesReport");
+	return Get(report, 0);
 }
 
-bool Reporter::Get(PadConfigurationReport& report)
+ReadDataResult Reporter::Get(SensorValuesReport& report, int timeoutMs)
 {
-	if(emulator) {
-		return true;
-	}
+	InputTiming timing;
+	return ReadData(Target(), report, timing, nullptr, timeoutMs, L"GetSensorValuesReport");
+}
 
-	return GetFeatureReport(myHid, report, L"GetPadConfigurationReport");
+ReadDataResult Reporter::Get(SensorValuesReport& report, InputTiming& timing, string& debugText, int timeoutMs)
+{
+	return ReadData(Target(), report, timing, &debugText, timeoutMs, L"GetSensorValuesReport");
 }
 
-bool Reporter::Get(NameReport& report)
+bool Reporter::Get(PadConfigurationReport& report)
 {
-	if(emulator) {
-		const char* name = "ADP Emulator";
-		memcpy(&report.name, name, sizeof(name));
-		report.size = sizeof(name);
-		
-		return true;
-	}
+	return GetFeatureReport(Target(), myPacing, report, L"GetPadConfigurationReport");
+}
 
-	return GetFeatureReport(myHid, report, L"GetNameReport");
+bool Reporter::Get(NameReport& report)
+{
+	return GetFeatureReport(Target(), myPacing, report, L"GetNameReport");
 }
 
 bool Reporter::Get(IdentificationReport& report)
 {
-	if(emulator) {
-		report.buttonCount = 12;
-		report.sensorCount = 12;
-		report.ledCount = 0;
-		
-		return true;
-	}
-
-	return GetFeatureReport(myHid, report, L"GetIdentificationReport");
+	return GetFeatureReport(Target(), myPacing, report, L"GetIdentificationReport");
 }
 
 bool Reporter::Get(IdentificationV2Report& report)
 {
-	if (emulator) {
-		report.buttonCount = 12;
-		report.sensorCount = 12;
-		report.ledCount = 0;
-
-		return true;
-	}
+	return GetFeatureReport(Target(), myPacing, report, L"GetIdentificationV2Report");
+}
 
-	return GetFeatureReport(myHid, report, L"GetIdentificationV2Report");
+bool Reporter::Get(IdentificationV3Report& report)
+{
+	return GetFeatureReport(Target(), myPacing, report, L"GetIdentificationV3Report");
 }
 
 bool Reporter::Get(LightRuleReport& report)
 {
-	if(emulator) {
-		return true;
-	}
-
-	return GetFeatureReport(myHid, report, L"GetLightRuleReport");
+	return GetFeatureReport(Target(), myPacing, report, L"GetLightRuleReport");
 }
 
 bool Reporter::Get(LedMappingReport& report)
 {
-	if(emulator) {
-		return true;
-	}
-
-	return GetFeatureReport(myHid, report, L"GetLedMappingReport");
+	return GetFeatureReport(Target(), myPacing, report, L"GetLedMappingReport");
 }
 
 bool Reporter::Get(SensorReport& report)
 {
-	if (emulator) {
-		return true;
-	}
-
-	return GetFeatureReport(myHid, report, L"GetSensorReport");
+	return GetFeatureReport(Target(), myPacing, report, L"GetSensorReport");
 }
 
 
 bool Reporter::Get(DebugReport& report)
 {
-	if (emulator) {
-		return true;
-	}
+	return GetFeatureReport(Target(), myPacing, report, L"GetDebugReport");
+}
 
-	return GetFeatureReport(myHid, report, L"GetDebugReport");
+bool Reporter::Get(StatsReport& report)
+{
+	return GetFeatureReport(Target(), myPacing, report, L"GetStatsReport");
 }
 
 void Reporter::SendReset()
 {
-	WriteData(myHid, REPORT_RESET, L"SendResetReport", false);
+	WriteData(Target(), myPacing, REPORT_RESET, L"SendResetReport", false);
 }
 
 void Reporter::SendFactoryReset()
 {
-	WriteData(myHid, REPORT_FACTORY_RESET, L"SendFactoryResetReport", false);
+	WriteData(Target(), myPacing, REPORT_FACTORY_RESET, L"SendFactoryResetReport", false);
 }
 
 bool Reporter::SendSaveConfiguration()
 {
-	if(emulator) {
-		return true;
-	}
-
-	return WriteData(myHid, REPORT_SAVE_CONFIGURATION, L"SendSaveConfigurationReport", true);
+	return WriteData(Target(), myPacing, REPORT_SAVE_CONFIGURATION, L"SendSaveConfigurationReport", true);
 }
 
 bool Reporter::Send(const PadConfigurationReport& report)
 {
-	if(emulator) {
-		return true;
-	}
-
-	return SendFeatureReport(myHid, report, L"SendPadConfigurationReport");
+	return SendFeatureReport(Target(), myPacing, report, L"SendPadConfigurationReport");
 }
 
 bool Reporter::Send(const NameReport& report)
 {
-	if(emulator) {
-		return true;
-	}
-
-	return SendFeatureReport(myHid, report, L"SendNameReport");
+	return SendFeatureReport(Target(), myPacing, report, L"SendNameReport");
 }
 
 bool Reporter::Send(const LightRuleReport& report)
 {
-	if(emulator) {
-		return true;
-	}
-
-	return SendFeatureReport(myHid, report, L"SendLightRuleReport");
+	return SendFeatureReport(Target(), myPacing, report, L"SendLightRuleReport");
 }
 
 bool Reporter::Send(const LedMappingReport& report)
 {
-	if(emulator) {
-		return true;
-	}
-	
-	return SendFeatureReport(myHid, report, L"SendLedMappingReport");
+	return SendFeatureReport(Target(), myPacing, report, L"SendLedMappingReport");
 }
 
 bool Reporter::Send(const SensorReport& report)
 {
-	return SendFeatureReport(myHid, report, L"SendSensorReport");
+	return SendFeatureReport(Target(), myPacing, report, L"SendSensorReport");
 }
 
 bool Reporter::Send(const SetPropertyReport& report)
 {
-	if(emulator) {
-		return true;
-	}
-	
-	return SendFeatureReport(myHid, report, L"SendSetPropertyReport");
+	return SendFeatureReport(Target(), myPacing, report, L"SendSetPropertyReport");
 }
 
 bool Reporter::SendAndGet(NameReport& report)
@@ -290,9 +358,6 @@ bool Reporter::SendAndGet(NameReport& report)
 	if(!Send(report))
 		return false;
 
-	// Wait for the controller to get into a ready state
-	std::this_thread::sleep_for(2ms);
-
 	if (!Get(report))
 		return false;
 
@@ -304,13 +369,68 @@ bool Reporter::SendAndGet(PadConfigurationReport& report)
 	if (!Send(report))
 		return false;
 
-	// Wait for the controller to get into a ready state
-	std::this_thread::sleep_for(2ms);
-
 	if (!Get(report))
 		return false;
 
 	return true;
 }
 
+bool Reporter::ReadConfigBlock(uint8_t* data, size_t offset, size_t size)
+{
+	SetPropertyReport selectReport;
+	selectReport.propertyId = WriteU32LE(SetPropertyReport::CONFIG_BLOCK_OFFSET);
+	selectReport.propertyValue = WriteU32LE((uint32_t)offset);
+	if (!Send(selectReport))
+		return false;
+
+	// Every read continues where the previous one ended.
+	for (size_t position = 0; position < size;)
+	{
+		ConfigBlockReport report;
+		if (!GetFeatureReport(Target(), myPacing, report, L"GetConfigBlockReport"))
+			return false;
+
+		size_t length = min((size_t)report.length, size - position);
+		if ((size_t)ReadU16LE(report.offset) != (size_t)(offset + position) || length == 0)
+		{
+			Log::Writef(L"GetConfigBlockReport :: unexpected chunk at %i", ReadU16LE(report.offset));
+			return false;
+		}
+
+		memcpy(data + position, report.data, length);
+		position += length;
+	}
+
+	return true;
+}
+
+bool Reporter::WriteConfigBlock(const uint8_t* data, size_t offset, size_t size, int sensorCount)
+{
+	for (size_t position = 0; position < size;)
+	{
+		ConfigBlockReport report;
+		size_t length = min((size_t)CONFIG_BLOCK_DATA_SIZE, size - position);
+
+		// End the chunk before an entry that does not fit in it completely.
+		if (position + length < size)
+		{
+			size_t entryStart = ConfigBlockEntryStart(sensorCount, offset + position + length);
+			if (entryStart > offset + position)
+				length = entryStart - (offset + position);
+		}
+
+		memset(report.data, 0, sizeof(report.data));
+		report.offset = WriteU16LE((uint16_t)(offset + position));
+		report.length = (uint8_t)length;
+		memcpy(report.data, data + position, length);
+
+		if (!SendFeatureReport(Target(), myPacing, report, L"SendConfigBlockReport"))
+			return false;
+
+		position += length;
+	}
+
+	return true;
+}
+
 }; // namespace adp.
@@ -1,6 +1,10 @@
 #pragma once
 
 #include "stdint.h"
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
 #include "hidapi.h"
 
 // Potentially defined by WinSock2.h
@@ -38,12 +42,19 @@ enum ReportId
 	REPORT_SENSOR			  = 0xC,
 	REPORT_DEBUG			  = 0xD,
 	REPORT_IDENTIFICATION_V2  = 0xE,
+	REPORT_IDENTIFICATION_V3  = 0xF,
+	REPORT_SENSOR_VALUES_COMPACT = 0x10,
+	REPORT_CONFIG_BLOCK       = 0x11,
+	REPORT_SENSOR_VALUES_TIMED = 0x12,
+	REPORT_DEBUG_STREAM       = 0x13,
+	REPORT_STATS              = 0x14,
 };
 
 enum class ReadDataResult
 {
 	NO_DATA,
 	SUCCESS,
+	BUTTONS_ONLY, // A compact report was read, only the button bits of the sensor values report are valid.
 	FAILURE,
 };
 
@@ -53,6 +64,48 @@ struct color24 { uint8_t red, green, blue; };
 
 struct float32_le { uint32_le bits; };
 
+static_assert(sizeof(float) == sizeof(uint32_t), "32-bit float required");
+
+inline int ReadU16LE(uint16_le u16)
+{
+	return u16.bytes[0] | u16.bytes[1] << 8;
+}
+
+inline uint32_t ReadU32LE(uint32_le u32)
+{
+	return u32.bytes[0] | (u32.bytes[1] << 8) | (u32.bytes[2] << 16) | (u32.bytes[3] << 24);
+}
+
+inline float ReadF32LE(float32_le f32)
+{
+	uint32_t u32 = ReadU32LE(f32.bits);
+	return *reinterpret_cast<float*>(&u32);
+}
+
+inline uint16_le WriteU16LE(int value)
+{
+	uint16_le u16;
+	u16.bytes[0] = value & 0xFF;
+	u16.bytes[1] = (value >> 8) & 0xFF;
+	return u16;
+}
+
+inline uint32_le WriteU32LE(uint32_t value)
+{
+	uint32_le u32;
+	u32.bytes[0] = value & 0xFF;
+	u32.bytes[1] = (value >> 8) & 0xFF;
+	u32.bytes[2] = (value >> 16) & 0xFF;
+	u32.bytes[3] = (value >> 24) & 0xFF;
+	return u32;
+}
+
+inline float32_le WriteF32LE(float value)
+{
+	uint32_t u32 = *reinterpret_cast<uint32_t*>(&value);
+	return { WriteU32LE(u32) };
+}
+
 struct SensorValuesReport
 {
 	uint8_t reportId = REPORT_SENSOR_VALUES;
@@ -60,6 +113,18 @@ struct SensorValuesReport
 	uint16_le sensorValues[MAX_SENSOR_COUNT];
 };
 
+// Sent instead of the sensor values report while input timing is enabled. Times come from a free-running microsecond
+// clock on the pad. The report time is taken when the report is handed to USB, button change times hold the lower
+// 16 bits of the time each button was last pressed or released.
+struct SensorValuesTimedReport
+{
+	uint8_t reportId = REPORT_SENSOR_VALUES_TIMED;
+	uint16_le buttonBits;
+	uint16_le sensorValues[MAX_SENSOR_COUNT];
+	uint32_le reportTime;
+	uint16_le buttonChangeTimes[MAX_BUTTON_COUNT];
+};
+
 struct PadConfigurationReport
 {
 	uint8_t reportId = REPORT_PAD_CONFIGURATION;
@@ -99,11 +164,25 @@ struct IdentificationV2Report : public IdentificationReport
 		FEATURE_DEBUG = 1 << 0,
 		FEATURE_DIGIPOT = 1 << 1,
 		FEATURE_LIGHTS = 1 << 2,
+		FEATURE_FILTERING = 1 << 3,
+		FEATURE_DEBUG_STREAM = 1 << 4,
+		FEATURE_STATS = 1 << 5,
 	};
 
 	uint16_le features;
 };
 
+struct IdentificationV3Report : public IdentificationV2Report
+{
+	IdentificationV3Report()
+	{
+		reportId = REPORT_IDENTIFICATION_V3;
+	}
+
+	uint16_le reportRate;
+	uint32_le missedFrames;
+};
+
 struct LightRuleReport
 {
 	uint8_t reportId = REPORT_LIGHT_RULE;
@@ -131,8 +210,14 @@ struct SensorReport
 	enum Ids
 	{
 		ADC_DISABLED		= 1 << 0,
+		ADC_MEDIAN_FILTER	= 1 << 1,
 	};
 
+	// Bits 4-6 of the flags hold the oversampling shift, 2^shift samples are averaged into every sensor value.
+	static constexpr int OVERSAMPLE_SHIFT_MASK = 0x70;
+	static constexpr int OVERSAMPLE_SHIFT_OFFSET = 4;
+	static constexpr int MAX_OVERSAMPLE_SHIFT = 4;
+
 	uint8_t reportId = REPORT_SENSOR;
 	uint8_t index;
 	uint16_le threshold;
@@ -148,13 +233,29 @@ struct SetPropertyReport
 	{
 		SELECTED_LIGHT_RULE_INDEX = 0,
 		SELECTED_LED_MAPPING_INDEX = 1,
-		SELECTED_SENSOR_INDEX = 2
+		SELECTED_SENSOR_INDEX = 2,
+		ANALOG_STREAM = 3,
+		CONFIG_BLOCK_OFFSET = 4,
+		INPUT_TIMING = 5,
+		DEBUG_STREAM = 6,
+		RESET_STATS = 7,
 	};
 	uint8_t reportId = REPORT_SET_PROPERTY;
 	uint32_le propertyId;
 	uint32_le propertyValue;
 };
 
+constexpr int CONFIG_BLOCK_DATA_SIZE = 58;
+
+// A chunk of the config block, which is a flat copy of the sensor, light rule and led mapping tables in the firmware.
+struct ConfigBlockReport
+{
+	uint8_t reportId = REPORT_CONFIG_BLOCK;
+	uint16_le offset;
+	uint8_t length;
+	uint8_t data[CONFIG_BLOCK_DATA_SIZE];
+};
+
 struct DebugReport
 {
 	uint8_t reportId = REPORT_DEBUG;
@@ -162,24 +263,131 @@ struct DebugReport
 	char messagePacket[32];
 };
 
+// Debug text that the pad sends in between input reports, while the debug stream is enabled.
+struct DebugStreamReport
+{
+	uint8_t reportId = REPORT_DEBUG_STREAM;
+	uint8_t length;
+	char data[62];
+};
+
+// Parts of the firmware that the pad times itself.
+enum StatsStage
+{
+	STATS_MAIN_LOOP,     // One pass through the main loop.
+	STATS_PAD_UPDATE,    // Turning a scan of the sensors into button states.
+	STATS_LIGHTS_RENDER, // Working out the led colors.
+	STATS_LED_WRITE,     // Sending the colors to the led strip, only when they changed.
+	STATS_EEPROM_WRITE,  // Writing a byte of the configuration to eeprom, until the main loop sees it done.
+	NUM_STATS_STAGES
+};
+
+// Performance counters of the firmware. Times are in microseconds, averages are over the last second and maximums
+// since the pad started or the stats were reset.
+struct StatsReport
+{
+	uint8_t reportId = REPORT_STATS;
+	struct
+	{
+		uint16_le averageMicros;
+		uint16_le maxMicros;
+		uint32_le runsPerSecond;
+	} stages[NUM_STATS_STAGES];
+	uint16_le adcConversionsPerSecond;
+	uint16_le reportRate;
+	uint32_le missedFrames;
+};
+
 #pragma pack()
 
+// The timestamps of a timed sensor values report, in microseconds of the pad clock.
+struct InputTiming
+{
+	bool valid = false;
+	uint32_t reportTime = 0;
+	uint16_t buttonChangeTimes[MAX_BUTTON_COUNT] = {};
+};
+
+// Every entry in the config block is the tail of the matching report, starting after the report id and index.
+constexpr size_t CONFIG_BLOCK_SENSOR_SIZE = sizeof(SensorReport) - offsetof(SensorReport, threshold);
+constexpr size_t CONFIG_BLOCK_LIGHT_RULE_SIZE = sizeof(LightRuleReport) - offsetof(LightRuleReport, flags);
+constexpr size_t CONFIG_BLOCK_LED_MAPPING_SIZE = sizeof(LedMappingReport) - offsetof(LedMappingReport, flags);
+
+inline size_t SensorBlockOffset(int sensorIndex)
+{
+	return sensorIndex * CONFIG_BLOCK_SENSOR_SIZE;
+}
+
+inline size_t LightRuleBlockOffset(int sensorCount, int lightRuleIndex)
+{
+	return sensorCount * CONFIG_BLOCK_SENSOR_SIZE + lightRuleIndex * CONFIG_BLOCK_LIGHT_RULE_SIZE;
+}
+
+inline size_t LedMappingBlockOffset(int sensorCount, int ledMappingIndex)
+{
+	return LightRuleBlockOffset(sensorCount, MAX_LIGHT_RULES) + ledMappingIndex * CONFIG_BLOCK_LED_MAPPING_SIZE;
+}
+
+inline size_t ConfigBlockSize(int sensorCount)
+{
+	return LedMappingBlockOffset(sensorCount, MAX_LED_MAPPINGS);
+}
+
+// Offset of the start of the entry that holds the given offset of the config block.
+inline size_t ConfigBlockEntryStart(int sensorCount, size_t offset)
+{
+	size_t lightRulesOffset = LightRuleBlockOffset(sensorCount, 0);
+	size_t ledMappingsOffset = LedMappingBlockOffset(sensorCount, 0);
+
+	if (offset < lightRulesOffset)
+		return offset - offset % CONFIG_BLOCK_SENSOR_SIZE;
+	if (offset < ledMappingsOffset)
+		return offset - (offset - lightRulesOffset) % CONFIG_BLOCK_LIGHT_RULE_SIZE;
+	return offset - (offset - ledMappingsOffset) % CONFIG_BLOCK_LED_MAPPING_SIZE;
+}
+
+// The pad needs a moment to process a written feature report before it accepts the next transfer. Instead of
+// sleeping before every transfer, only the part of the gap that has not passed yet is waited for. The gap grows when
+// transfers fail and shrinks back to the minimum as they succeed again. The minimum is one USB frame, the pad handles
+// a feature report in the main loop of the frame it arrives in, slower pads are covered by the back-off.
+class TransferPacing
+{
+public:
+	void WaitForGap();
+	void TransferDone(bool isWrite, bool success);
+
+private:
+	std::chrono::steady_clock::time_point myLastWrite;
+	std::chrono::microseconds myGap = MIN_GAP;
+
+	static constexpr std::chrono::microseconds MIN_GAP{ 1000 };
+	static constexpr std::chrono::microseconds MAX_GAP{ 16000 };
+};
+
+class PadEmulator;
+struct HidTarget;
+
 class Reporter
 {
 public:
 	Reporter(hid_device* device);
-	Reporter();
+	Reporter(std::unique_ptr<PadEmulator> emulator);
 	~Reporter();
 
 	ReadDataResult Get(SensorValuesReport& report);
+	ReadDataResult Get(SensorValuesReport& report, int timeoutMs);
+	// Debug stream reports that come in while waiting for sensor values are appended to the debug text.
+	ReadDataResult Get(SensorValuesReport& report, InputTiming& timing, std::string& debugText, int timeoutMs);
 	bool Get(PadConfigurationReport& report);
 	bool Get(NameReport& report);
 	bool Get(IdentificationReport& report);
 	bool Get(IdentificationV2Report& report);
+	bool Get(IdentificationV3Report& report);
 	bool Get(LightRuleReport& report);
 	bool Get(LedMappingReport& report);
 	bool Get(SensorReport& report);
 	bool Get(DebugReport& report);
+	bool Get(StatsReport& report);
 
 	void SendReset();
 	void SendFactoryReset();
@@ -195,9 +403,18 @@ public:
 	bool SendAndGet(NameReport& report);
 	bool SendAndGet(PadConfigurationReport& report);
 
+	// Reads or writes part of the config block, in as many transfers as needed. The firmware applies every transfer
+	// right away, so writes are split at entry boundaries and never hand it half an entry. The offset of a write must
+	// be the start of an entry.
+	bool ReadConfigBlock(uint8_t* data, size_t offset, size_t size);
+	bool WriteConfigBlock(const uint8_t* data, size_t offset, size_t size, int sensorCount);
+
 private:
+	HidTarget Target();
+
 	hid_device* myHid;
-	bool emulator = false;
+	std::unique_ptr<PadEmulator> myEmulator;
+	TransferPacing myPacing;
 };
 
 }; // namespace adp.
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace adp {
+
+// Fixed-capacity, lock-free ring buffer for exactly one producer thread and one consumer thread.
+// Push may only be called by the producer, Pop and Clear only by the consumer. Capacity must be a power of two.
+template <typename T, size_t Capacity>
+class RingBuffer
+{
+public:
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "ring buffer capacity must be a power of two");
+
+	// Returns false if the buffer is full, in which case the item is dropped.
+	bool Push(const T& item)
+	{
+		auto head = myHead.load(std::memory_order_relaxed);
+		if (head - myTail.load(std::memory_order_acquire) == Capacity)
+			return false;
+
+		myItems[head & (Capacity - 1)] = item;
+		myHead.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Returns false if the buffer is empty.
+	bool Pop(T& item)
+	{
+		auto tail = myTail.load(std::memory_order_relaxed);
+		if (tail == myHead.load(std::memory_order_acquire))
+			return false;
+
+		item = myItems[tail & (Capacity - 1)];
+		myTail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	void Clear()
+	{
+		myTail.store(myHead.load(std::memory_order_acquire), std::memory_order_release);
+	}
+
+	size_t Size() const
+	{
+		return myHead.load(std::memory_order_acquire) - myTail.load(std::memory_order_acquire);
+	}
+
+	static constexpr size_t capacity = Capacity;
+
+private:
+	T myItems[Capacity];
+
+	// Head and tail live on separate cache lines so the producer and consumer do not contend.
+	alignas(64) std::atomic<size_t> myHead{ 0 };
+	alignas(64) std::atomic<size_t> myTail{ 0 };
+};
+
+}; // namespace adp.
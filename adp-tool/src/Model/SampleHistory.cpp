@@ -0,0 +1,102 @@
+#include "Adp.h"
+
+#include <algorithm>
+
+#include "Model/SampleHistory.h"
+
+using namespace std;
+
+namespace adp {
+
+static constexpr int64_t BlockSize(int level)
+{
+	return (level == 0) ? 1 : SampleHistory::LEVEL_FACTOR * BlockSize(level - 1);
+}
+
+static void Include(SampleRange& range, const SampleRange& other)
+{
+	range.min = min(range.min, other.min);
+	range.max = max(range.max, other.max);
+}
+
+void SampleHistory::Reset(int numSensors)
+{
+	mySensors.resize(numSensors);
+	for (auto& levels : mySensors)
+	{
+		for (auto& level : levels)
+		{
+			level.blocks.assign(LEVEL_SIZE, SampleRange());
+			level.current = SampleRange();
+		}
+	}
+	myNumSamples = 0;
+}
+
+void SampleHistory::Add(const SensorValuesReport& report)
+{
+	for (size_t i = 0; i < mySensors.size(); ++i)
+	{
+		uint16_t value = (uint16_t)ReadU16LE(report.sensorValues[i]);
+		for (int l = 0; l < NUM_LEVELS; ++l)
+		{
+			auto& level = mySensors[i][l];
+			int64_t blockSize = BlockSize(l);
+
+			if (myNumSamples % blockSize == 0)
+				level.current = { value, value };
+			else
+				Include(level.current, { value, value });
+
+			if ((myNumSamples + 1) % blockSize == 0)
+				level.blocks[(myNumSamples / blockSize) % LEVEL_SIZE] = level.current;
+		}
+	}
+	++myNumSamples;
+}
+
+int SampleHistory::Columns(int sensorIndex, int numSamples, int numColumns, vector<SampleRange>& ranges) const
+{
+	ranges.clear();
+	if (sensorIndex < 0 || sensorIndex >= (int)mySensors.size() || numSamples <= 0 || numColumns <= 0)
+		return 0;
+
+	numColumns = min(numColumns, numSamples);
+	double samplesPerColumn = (double)numSamples / numColumns;
+
+	// The coarsest level with at least one block per column, unless a coarser level is needed to cover all samples.
+	int l = 0;
+	while (l + 1 < NUM_LEVELS && BlockSize(l + 1) <= samplesPerColumn)
+		++l;
+	while (l + 1 < NUM_LEVELS && numSamples > LEVEL_SIZE * BlockSize(l))
+		++l;
+
+	auto& level = mySensors[sensorIndex][l];
+	int64_t blockSize = BlockSize(l);
+	int64_t numComplete = myNumSamples / blockSize;
+	int64_t numBlocks = numComplete + ((myNumSamples % blockSize) ? 1 : 0);
+	int64_t oldestBlock = max((int64_t)0, numComplete - LEVEL_SIZE);
+	int64_t firstSample = myNumSamples - numSamples;
+
+	for (int c = 0; c < numColumns; ++c)
+	{
+		int64_t begin = firstSample + (int64_t)(c * samplesPerColumn);
+		int64_t end = firstSample + (int64_t)((c + 1) * samplesPerColumn);
+
+		// Every block goes to the column it starts in, the last column gets the incomplete block too.
+		int64_t beginBlock = max(max(begin, (int64_t)0) / blockSize, oldestBlock);
+		int64_t endBlock = (c == numColumns - 1) ? numBlocks : max(end, (int64_t)0) / blockSize;
+		if (end <= 0 || endBlock <= oldestBlock || beginBlock >= numBlocks)
+			continue;
+		endBlock = max(endBlock, beginBlock + 1);
+
+		SampleRange range = { UINT16_MAX, 0 };
+		for (int64_t b = beginBlock; b < endBlock; ++b)
+			Include(range, (b < numComplete) ? level.blocks[b % LEVEL_SIZE] : level.current);
+		ranges.push_back(range);
+	}
+
+	return numColumns;
+}
+
+}; // namespace adp.
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "Model/Reporter.h"
+
+namespace adp {
+
+// Lowest and highest device sensor value in a stretch of samples.
+struct SampleRange
+{
+	uint16_t min = 0;
+	uint16_t max = 0;
+};
+
+// Keeps the value of every sensor in every input report, for drawing graphs at any zoom level. Besides the samples
+// themselves, it keeps the minimum and maximum of blocks of 8 and of 64 samples. A graph takes the minimum and maximum
+// per pixel column from the coarsest level that still has more than one block per column, so a short spike is never
+// averaged out, however long the time window is.
+class SampleHistory
+{
+public:
+	static constexpr int NUM_LEVELS = 3;
+	static constexpr int LEVEL_FACTOR = 8;
+
+	// Blocks kept per level. The coarsest level covers over a minute at the highest report rate of 8 kHz.
+	static constexpr int LEVEL_SIZE = 65536;
+
+	void Reset(int numSensors);
+
+	void Add(const SensorValuesReport& report);
+
+	int64_t NumSamples() const { return myNumSamples; }
+
+	// Splits the most recent samples of a sensor in columns, and gives the range of values in each column. Returns the
+	// number of columns the samples are split in, which is less than requested if there are fewer samples. Columns
+	// from before the first sample are left out, the last range is always the newest column.
+	int Columns(int sensorIndex, int numSamples, int numColumns, std::vector<SampleRange>& ranges) const;
+
+private:
+	struct Level
+	{
+		std::vector<SampleRange> blocks;
+		SampleRange current; // the block that is not complete yet.
+	};
+
+	std::vector<std::array<Level, NUM_LEVELS>> mySensors;
+	int64_t myNumSamples = 0;
+};
+
+}; // namespace adp.
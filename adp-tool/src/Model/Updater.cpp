@@ -90,7 +90,7 @@ void SoftwareUpdate::Install(void (*updateInstalledCallback)(bool))
 			}
 			// Request failed
 			case wxWebRequest::State_Failed:
-				Log::Writef(L"Downloading update failed: %s", evt.GetErrorDescription());
+				Log::Writef(L"Downloading update failed: %ls", evt.GetErrorDescription().wc_str());
 				(*updateInstalledCallback)(false);
 				delete myEvtHandler;
 				break;
@@ -113,7 +113,7 @@ void SoftwareUpdate::Install(void (*updateInstalledCallback)(bool))
 			return;
 		}
 
-		Log::Writef(L"Installing %s update", BoardTypeToString(pad->boardType));
+		Log::Writef(L"Installing %ls update", BoardTypeToString(pad->boardType));
 
 		wxEvtHandler* myEvtHandler = new wxEvtHandler();
 		wxWebRequest request = wxWebSession::GetDefault().CreateRequest(
@@ -156,7 +156,7 @@ void SoftwareUpdate::Install(void (*updateInstalledCallback)(bool))
 			}
 			// Request failed
 			case wxWebRequest::State_Failed:
-				Log::Writef(L"Downloading update failed: %ls", evt.GetErrorDescription());
+				Log::Writef(L"Downloading update failed: %ls", evt.GetErrorDescription().wc_str());
 				(*updateInstalledCallback)(false);
 				delete myEvtHandler;
 				break;
@@ -277,7 +277,7 @@ void Updater::CheckForAdpUpdates(void (*updateFoundCallback)(SoftwareUpdate&))
 		}
 		// Request failed
 		case wxWebRequest::State_Failed:
-			Log::Writef(L"Finding updates failed: %hs", evt.GetErrorDescription());
+			Log::Writef(L"Finding updates failed: %ls", evt.GetErrorDescription().wc_str());
 			delete myEventHandler;
 			break;
 		}
@@ -357,7 +357,7 @@ void Updater::CheckForFirmwareUpdates(void (*updateFoundCallback)(SoftwareUpdate
 		}
 		// Request failed
 		case wxWebRequest::State_Failed:
-			Log::Writef(L"Finding updates failed: %ls", evt.GetErrorDescription());
+			Log::Writef(L"Finding updates failed: %ls", evt.GetErrorDescription().wc_str());
 			delete myEventHandler;
 			break;
 		}
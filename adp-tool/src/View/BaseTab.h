@@ -9,6 +9,12 @@ using json = nlohmann::json;
 
 namespace adp {
 
+// Tabs that do not ask for something else are ticked at the rate the device state is updated.
+constexpr int DEFAULT_TICK_INTERVAL_MS = 10;
+
+// Refresh rate for tabs that show live sensor values, about the frame rate of a display.
+constexpr int LIVE_TICK_INTERVAL_MS = 16;
+
 class BaseTab
 {
 public:
@@ -19,6 +25,13 @@ public:
     virtual void HandleChanges(DeviceChanges changes) {}
 
     virtual void Tick() {}
+
+    // How often Tick is called while the tab is shown. Hidden tabs are not ticked, nor is any tab while the main
+    // window is minimized.
+    virtual int TickInterval() const { return DEFAULT_TICK_INTERVAL_MS; }
+
+    // Whether the tab shows live sensor values. The pad only streams them while such a tab is shown.
+    virtual bool ShowsSensorValues() const { return false; }
 };
 
 }; // namespace adp.
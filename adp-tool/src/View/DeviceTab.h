@@ -5,6 +5,8 @@
 #include "wx/stattext.h"
 #include "wx/gauge.h"
 
+#include "Model/Firmware.h"
+
 #include "View/BaseTab.h"
 
 using namespace std;
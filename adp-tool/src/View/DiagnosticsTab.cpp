@@ -0,0 +1,128 @@
+#include "Adp.h"
+
+#include "wx/sizer.h"
+
+#include "Model/Device.h"
+
+#include "View/DiagnosticsTab.h"
+
+using namespace std;
+
+namespace adp {
+
+static constexpr const wchar_t* DiagnosticsMsg =
+    L"Shows how long the firmware spends on each part of its work, as measured\n"
+    L"on the pad. Averages are over the last second, maximums since the pad\n"
+    L"started or since the last reset. EEPROM writes include the time until\n"
+    L"the main loop sees them done.";
+
+static constexpr const wchar_t* StageLabels[NUM_STATS_STAGES] =
+{
+    L"Main loop", L"Pad update", L"Lights render", L"LED strip write", L"EEPROM write until seen",
+};
+
+static constexpr const wchar_t* ColumnLabels[] =
+{
+    L"Average", L"Max", L"Per second",
+};
+
+static constexpr const wchar_t* TotalLabels[] =
+{
+    L"ADC conversions per second", L"Reports per second", L"Missed frames",
+};
+
+const wchar_t* DiagnosticsTab::Title = L"Diagnostics";
+
+enum Ids { RESET_BUTTON = 1 };
+
+DiagnosticsTab::DiagnosticsTab(wxWindow* owner)
+    : wxWindow(owner, wxID_ANY)
+{
+    auto sizer = new wxBoxSizer(wxVERTICAL);
+    sizer->AddStretchSpacer();
+
+    auto lDiagnostics = new wxStaticText(this, wxID_ANY, DiagnosticsMsg,
+        wxDefaultPosition, wxDefaultSize, wxALIGN_CENTRE_HORIZONTAL);
+    sizer->Add(lDiagnostics, 0, wxALIGN_CENTER_HORIZONTAL, 0);
+
+    auto grid = new wxFlexGridSizer(NUM_STATS_STAGES + 1, NUM_COLUMNS + 1, 5, 20);
+    grid->AddSpacer(0);
+    for (auto label : ColumnLabels)
+        grid->Add(new wxStaticText(this, wxID_ANY, label), 0, wxALIGN_RIGHT);
+
+    for (int stage = 0; stage < NUM_STATS_STAGES; ++stage)
+    {
+        grid->Add(new wxStaticText(this, wxID_ANY, StageLabels[stage]));
+        for (int column = 0; column < NUM_COLUMNS; ++column)
+        {
+            myStageValues[stage][column] = new wxStaticText(this, wxID_ANY, L"-",
+                wxDefaultPosition, wxSize(80, -1), wxALIGN_RIGHT | wxST_NO_AUTORESIZE);
+            grid->Add(myStageValues[stage][column], 0, wxALIGN_RIGHT);
+        }
+    }
+    sizer->Add(grid, 0, wxALIGN_CENTER_HORIZONTAL | wxTOP, 20);
+
+    auto totals = new wxFlexGridSizer(NUM_TOTALS, 2, 5, 20);
+    for (int row = 0; row < NUM_TOTALS; ++row)
+    {
+        totals->Add(new wxStaticText(this, wxID_ANY, TotalLabels[row]));
+        myTotalValues[row] = new wxStaticText(this, wxID_ANY, L"-",
+            wxDefaultPosition, wxSize(80, -1), wxALIGN_RIGHT | wxST_NO_AUTORESIZE);
+        totals->Add(myTotalValues[row], 0, wxALIGN_RIGHT);
+    }
+    sizer->Add(totals, 0, wxALIGN_CENTER_HORIZONTAL | wxTOP, 20);
+
+    auto bReset = new wxButton(this, RESET_BUTTON, L"Reset maximums", wxDefaultPosition, wxSize(200, -1));
+    sizer->Add(bReset, 0, wxALIGN_CENTER_HORIZONTAL | wxTOP, 20);
+
+    sizer->AddStretchSpacer();
+    SetSizer(sizer);
+}
+
+void DiagnosticsTab::Tick()
+{
+    UpdateValues();
+}
+
+void DiagnosticsTab::UpdateValues()
+{
+    PadStats stats;
+    if (!Device::Stats(stats))
+    {
+        for (auto& row : myStageValues)
+            for (auto value : row)
+                value->SetLabel(L"-");
+        for (auto value : myTotalValues)
+            value->SetLabel(L"-");
+        return;
+    }
+
+    for (int stage = 0; stage < NUM_STATS_STAGES; ++stage)
+    {
+        auto& s = stats.stages[stage];
+
+        // Stages that did not run in the last second, like lights on a pad without LEDs, have no average.
+        if (s.runsPerSecond > 0)
+            myStageValues[stage][0]->SetLabel(wxString::Format(L"%i us", s.averageMicros));
+        else
+            myStageValues[stage][0]->SetLabel(L"-");
+
+        myStageValues[stage][1]->SetLabel(s.maxMicros > 0 ? wxString::Format(L"%i us", s.maxMicros) : L"-");
+        myStageValues[stage][2]->SetLabel(wxString::Format(L"%i", s.runsPerSecond));
+    }
+
+    myTotalValues[0]->SetLabel(wxString::Format(L"%i", stats.adcConversionsPerSecond));
+    myTotalValues[1]->SetLabel(wxString::Format(L"%i", stats.reportRate));
+    myTotalValues[2]->SetLabel(wxString::Format(L"%u", stats.missedFrames));
+}
+
+void DiagnosticsTab::OnReset(wxCommandEvent& event)
+{
+    Device::ResetStats();
+}
+
+BEGIN_EVENT_TABLE(DiagnosticsTab, wxWindow)
+    EVT_BUTTON(RESET_BUTTON, DiagnosticsTab::OnReset)
+END_EVENT_TABLE()
+
+}; // namespace adp.
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "wx/window.h"
+#include "wx/button.h"
+#include "wx/stattext.h"
+
+#include "Model/Reporter.h"
+
+#include "View/BaseTab.h"
+
+namespace adp {
+
+class DiagnosticsTab : public BaseTab, public wxWindow
+{
+public:
+    static const wchar_t* Title;
+
+    DiagnosticsTab(wxWindow* owner);
+
+    void Tick() override;
+
+    // The pad updates its counters once per second.
+    int TickInterval() const override { return 500; }
+
+    void OnReset(wxCommandEvent& event);
+
+    wxWindow* GetWindow() override { return this; }
+
+    DECLARE_EVENT_TABLE()
+
+private:
+    static constexpr int NUM_COLUMNS = 3;
+    static constexpr int NUM_TOTALS = 3;
+
+    void UpdateValues();
+
+    wxStaticText* myStageValues[NUM_STATS_STAGES][NUM_COLUMNS];
+    wxStaticText* myTotalValues[NUM_TOTALS];
+};
+
+}; // namespace adp.
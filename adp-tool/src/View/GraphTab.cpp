@@ -1,11 +1,10 @@
 #include "Adp.h"
 
-#include <deque>
 #include <wx/memory.h>
 
 #include "wx/dcbuffer.h"
 #include "wx/stattext.h"
-#include "wx/timer.h"
+#include "wx/combobox.h"
 
 #include "Assets/Assets.h"
 
@@ -17,6 +16,12 @@ namespace adp {
 
 static constexpr int SENSOR_INDEX_NONE = -1;
 
+// Time windows the graph can show, in seconds.
+static constexpr double GRAPH_WINDOWS[] = { 0.1, 0.25, 0.5, 1.0, 3.0, 10.0, 30.0, 60.0 };
+static constexpr const wchar_t* GRAPH_WINDOW_LABELS[] = { L"100 ms", L"250 ms", L"500 ms", L"1 s", L"3 s", L"10 s", L"30 s", L"60 s" };
+static constexpr int NUM_GRAPH_WINDOWS = sizeof(GRAPH_WINDOWS) / sizeof(GRAPH_WINDOWS[0]);
+static constexpr int DEFAULT_GRAPH_WINDOW = 4;
+
 class GraphDisplay : public wxWindow
 {
 public:
@@ -25,11 +30,9 @@ public:
         , myOwner(owner)
     {
         SetMinSize(wxSize(10, 50)); 
-        myUpdateTimer.Bind(wxEVT_TIMER, &GraphDisplay::OnTimer, this);
-        myUpdateTimer.Start(1000 / SensorHistory::SAMPLE_RATE); // ~240 samples per second, adjust as needed
-        
     }
 
+    // Called by the tab, which is the only thing that repaints the graph.
     void Tick()
     {
         if (myAdjustingSensorIndex != SENSOR_INDEX_NONE)
@@ -45,6 +48,8 @@ public:
                 myAdjustingSensorIndex = SENSOR_INDEX_NONE;
             }
         }
+
+        Refresh(false);
     }
 
     void OnPaint(wxPaintEvent& evt)
@@ -52,22 +57,19 @@ public:
         wxBufferedPaintDC dc(this);
         auto size = GetClientSize();
 
+        if (mySensorIndices.empty())
+            return;
+
         // Add right margin so lines don't draw at the edge
         static constexpr int RIGHT_MARGIN = 10;
         int drawWidth = size.x - RIGHT_MARGIN;
         
-        // Ensure history is initialized
-        if (mySensorHistory.size() != mySensorIndices.size()) {
-            mySensorHistory.resize(mySensorIndices.size());
-        }
-        
         int graphHeight = size.y / mySensorIndices.size();
         
         for (size_t i = 0; i < mySensorIndices.size(); ++i)
         {
             int y = i * graphHeight;
             auto sensor = Device::Sensor(mySensorIndices[i]);
-            auto pressed = sensor ? sensor->pressed : false;
             auto threshold = sensor ? sensor->threshold : 0.0;
             
             if (myAdjustingSensorIndex == mySensorIndices[i])
@@ -81,38 +83,10 @@ public:
             dc.DrawRectangle(0, y, size.x, graphHeight);
             
             // Draw threshold line
-            dc.SetPen(wxPen(*wxGREEN, 2));
+            dc.SetPen(Pens::Green2px());
             dc.DrawLine(0, thresholdY, size.x, thresholdY);
             
-            // Draw the graph line
-            auto& history = mySensorHistory[i];
-            if (history.values.size() > 1)
-            {
-                dc.SetPen(wxPen(pressed ? *wxRED : *wxBLUE, 2));
-                
-                float xStep = drawWidth / (float)SensorHistory::MAX_SAMPLES;
-                int startIdx = SensorHistory::MAX_SAMPLES - history.values.size();
-                
-                for (size_t j = 1; j < history.values.size(); ++j)
-                {
-                    int x1 = (startIdx + j - 1) * xStep;
-                    int x2 = (startIdx + j) * xStep;
-
-                    if (history.values[j - 1] > threshold)
-                    {
-                      dc.SetPen(wxPen(*wxRED, 2));
-                    }
-                    else
-                    {
-                      dc.SetPen(wxPen(*wxBLUE, 2));
-                    }
-                    
-                    int value1Y = y + graphHeight - (history.values[j - 1] * graphHeight);
-                    int value2Y = y + graphHeight - (history.values[j] * graphHeight);
-                    
-                    dc.DrawLine(x1, value1Y, x2, value2Y);
-                }
-            }
+            DrawHistory(dc, mySensorIndices[i], threshold, y, graphHeight, drawWidth);
             
             // Draw sensitivity text
             auto sensitivityText = wxString::Format("%i%%", (int)std::lround(threshold * 100.0));
@@ -125,7 +99,7 @@ public:
             // Draw separator line between graphs
             if (i < mySensorIndices.size() - 1)
             {
-                dc.SetPen(wxPen(*wxWHITE, 1));
+                dc.SetPen(Pens::White1px());
                 dc.DrawLine(0, y + graphHeight, size.x, y + graphHeight);
             }
         }
@@ -143,6 +117,11 @@ public:
         }
     }
 
+    void OnMouseWheel(wxMouseEvent& event)
+    {
+        myOwner->Zoom(event.GetWheelRotation() > 0 ? -1 : 1);
+    }
+
     void SetTarget(const vector<int>& sensorIndices)
     {
         mySensorIndices = sensorIndices;
@@ -154,61 +133,86 @@ protected:
     wxSize DoGetBestSize() const override { return wxSize(20, 100); }
 
 private:
+    // Every pixel column shows the full range of values the sensor had in its stretch of time, drawn as a vertical
+    // line that connects to the next column. A column is red when it crosses the threshold and blue otherwise.
+    // Consecutive columns of the same color are drawn as one polyline, so there is only a handful of draw calls.
+    void DrawHistory(wxDC& dc, int sensorIndex, double threshold, int y, int graphHeight, int drawWidth)
+    {
+        int numColumns = Device::SensorHistory(sensorIndex, myOwner->WindowSeconds(), max(drawWidth, 1), myRanges);
+        int count = (int)myRanges.size();
+        if (count == 0)
+            return;
+
+        // Columns without samples yet are missing at the start, the newest column is always at the right.
+        float xStep = drawWidth / (float)numColumns;
+        int startIdx = numColumns - count;
+
+        myPoints.resize(count * 2);
+        for (int j = 0; j < count; ++j)
+        {
+            int x = (startIdx + j) * xStep;
+            int minY = y + graphHeight - (myRanges[j].min * graphHeight);
+            int maxY = y + graphHeight - (myRanges[j].max * graphHeight);
+
+            // Alternating the direction keeps the connections between columns short.
+            myPoints[j * 2] = wxPoint(x, (j & 1) ? minY : maxY);
+            myPoints[j * 2 + 1] = wxPoint(x, (j & 1) ? maxY : minY);
+        }
+
+        int runStart = 0;
+        bool runAbove = myRanges[0].max > threshold;
+        for (int j = 1; j <= count; ++j)
+        {
+            bool above = (j < count) && myRanges[j].max > threshold;
+            if (j < count && above == runAbove)
+                continue;
+
+            // A run also includes the last point of the previous run, so the line has no gaps.
+            int first = max(runStart * 2 - 1, 0);
+            dc.SetPen(runAbove ? Pens::Red2px() : Pens::Blue2px());
+            dc.DrawLines(j * 2 - first, myPoints.data() + first);
+            runStart = j;
+            runAbove = above;
+        }
+    }
+
     GraphTab* myOwner;
     // This is currently just a single sensor, but leaving as a vector for now
     // in case I want to make it toggleable
     vector<int> mySensorIndices;
+    vector<SensorRange> myRanges;
+    vector<wxPoint> myPoints;
     int myAdjustingSensorIndex = SENSOR_INDEX_NONE;
     double myAdjustingSensorThreshold = 0.0;
-
-    struct SensorHistory {
-        std::deque<float> values;
-        static constexpr size_t SAMPLE_RATE = 120; // Samples per second
-        static constexpr size_t MAX_SAMPLES = 3 * SAMPLE_RATE; // 3 seconds of data 
-        
-        void AddValue(float value) {
-            values.push_back(value);
-            if (values.size() > MAX_SAMPLES) {
-                values.pop_front();
-            }
-        }
-        
-        void Clear() {
-            values.clear();
-        }
-    };
-    
-    std::vector<SensorHistory> mySensorHistory;
-    wxTimer myUpdateTimer;
-    
-    void OnTimer(wxTimerEvent& evt) {
-        // Update sensor history
-        for (size_t i = 0; i < mySensorIndices.size(); ++i) {
-            auto sensor = Device::Sensor(mySensorIndices[i]);
-            float value = sensor ? sensor->value : 0.0f;
-            
-            if (i >= mySensorHistory.size()) {
-                mySensorHistory.resize(mySensorIndices.size());
-            }
-            mySensorHistory[i].AddValue(value);
-        }
-        Refresh();
-    }
-
 };
 
 BEGIN_EVENT_TABLE(GraphDisplay, wxWindow)
     EVT_PAINT(GraphDisplay::OnPaint)
     EVT_LEFT_DOWN(GraphDisplay::OnClick)
+    EVT_MOUSEWHEEL(GraphDisplay::OnMouseWheel)
 END_EVENT_TABLE()
 
 const wchar_t* GraphTab::Title = L"Graph";
 
 GraphTab::GraphTab(wxWindow* owner, const PadState* pad)
     : wxWindow(owner, wxID_ANY)
+    , myWindowIndex(DEFAULT_GRAPH_WINDOW)
 {
     auto sizer = new wxBoxSizer(wxVERTICAL);
 
+    wxArrayString options;
+    for (auto label : GRAPH_WINDOW_LABELS)
+        options.Add(label);
+
+    myWindowSelection = new wxComboBox(this, wxID_ANY, options[myWindowIndex],
+        wxDefaultPosition, wxDefaultSize, options, wxCB_READONLY);
+    myWindowSelection->Bind(wxEVT_COMBOBOX, &GraphTab::OnWindowChanged, this);
+
+    auto windowSizer = new wxBoxSizer(wxHORIZONTAL);
+    windowSizer->Add(new wxStaticText(this, wxID_ANY, L"Time window"), 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+    windowSizer->Add(myWindowSelection, 0);
+    sizer->Add(windowSizer, 0, wxALL, 4);
+
     mySensorSizer = new wxBoxSizer(wxVERTICAL);
     sizer->Add(mySensorSizer, 1, wxEXPAND);
     UpdateDisplays();
@@ -224,13 +228,26 @@ void GraphTab::HandleChanges(DeviceChanges changes)
         UpdateDisplays();
 }
 
+double GraphTab::WindowSeconds() const
+{
+    return GRAPH_WINDOWS[myWindowIndex];
+}
+
+void GraphTab::Zoom(int steps)
+{
+    myWindowIndex = clamp(myWindowIndex + steps, 0, NUM_GRAPH_WINDOWS - 1);
+    myWindowSelection->SetSelection(myWindowIndex);
+}
+
+void GraphTab::OnWindowChanged(wxCommandEvent& event)
+{
+    myWindowIndex = clamp(myWindowSelection->GetSelection(), 0, NUM_GRAPH_WINDOWS - 1);
+}
+
 void GraphTab::Tick()
 {
     for (auto display : myGraphDisplays)
-    {
         display->Tick();
-        display->Refresh(false);
-    }
 }
 
 void GraphTab::UpdateDisplays()
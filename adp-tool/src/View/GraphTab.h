@@ -3,6 +3,7 @@
 #include "wx/window.h"
 #include "wx/sizer.h"
 #include "wx/slider.h"
+#include "wx/combobox.h"
 
 #include "View/BaseTab.h"
 
@@ -23,14 +24,23 @@ public:
 
     void HandleChanges(DeviceChanges changes) override;
     void Tick() override;
+    int TickInterval() const override { return LIVE_TICK_INTERVAL_MS; }
+    bool ShowsSensorValues() const override { return true; }
 
     wxWindow* GetWindow() override { return this; }
 
+    // The time shown by the graphs, zooming steps through the available windows.
+    double WindowSeconds() const;
+    void Zoom(int steps);
+
 private:
     void UpdateDisplays();
+    void OnWindowChanged(wxCommandEvent& event);
 
     vector<GraphDisplay*> myGraphDisplays;
     wxBoxSizer* mySensorSizer;
+    wxComboBox* myWindowSelection;
+    int myWindowIndex;
     double myReleaseThreshold = 1.0;
     bool myIsAdjustingReleaseThreshold = false;
 };
@@ -0,0 +1,140 @@
+#include "Adp.h"
+
+#include "wx/sizer.h"
+#include "wx/filedlg.h"
+
+#include "Model/Device.h"
+#include "Model/LatencyStats.h"
+#include "Model/Log.h"
+
+#include "View/LatencyTab.h"
+
+using namespace std;
+
+namespace adp {
+
+static constexpr const wchar_t* LatencyMsg =
+    L"Measures the time from a button crossing its threshold to the pad sending\n"
+    L"the report with the change, and the spacing between reports. The most\n"
+    L"recent minute is shown, export appends the results to a CSV file.";
+
+static constexpr const wchar_t* RowLabels[] =
+{
+    L"Press to report", L"Report interval", L"Report jitter", L"Host interval",
+};
+
+static constexpr const wchar_t* ColumnLabels[] =
+{
+    L"Count", L"p50", L"p99", L"Max",
+};
+
+const wchar_t* LatencyTab::Title = L"Latency";
+
+enum Ids { TOGGLE_BUTTON = 1, RESET_BUTTON = 2, EXPORT_BUTTON = 3 };
+
+LatencyTab::LatencyTab(wxWindow* owner)
+    : wxWindow(owner, wxID_ANY)
+{
+    auto sizer = new wxBoxSizer(wxVERTICAL);
+    sizer->AddStretchSpacer();
+
+    auto lLatency = new wxStaticText(this, wxID_ANY, LatencyMsg,
+        wxDefaultPosition, wxDefaultSize, wxALIGN_CENTRE_HORIZONTAL);
+    sizer->Add(lLatency, 0, wxALIGN_CENTER_HORIZONTAL, 0);
+
+    auto grid = new wxFlexGridSizer(NUM_ROWS + 1, NUM_COLUMNS + 1, 5, 20);
+    grid->AddSpacer(0);
+    for (auto label : ColumnLabels)
+        grid->Add(new wxStaticText(this, wxID_ANY, label), 0, wxALIGN_RIGHT);
+
+    for (int row = 0; row < NUM_ROWS; ++row)
+    {
+        grid->Add(new wxStaticText(this, wxID_ANY, RowLabels[row]));
+        for (int column = 0; column < NUM_COLUMNS; ++column)
+        {
+            myValues[row][column] = new wxStaticText(this, wxID_ANY, L"-",
+                wxDefaultPosition, wxSize(70, -1), wxALIGN_RIGHT | wxST_NO_AUTORESIZE);
+            grid->Add(myValues[row][column], 0, wxALIGN_RIGHT);
+        }
+    }
+    sizer->Add(grid, 0, wxALIGN_CENTER_HORIZONTAL | wxTOP, 20);
+
+    myToggleButton = new wxButton(this, TOGGLE_BUTTON,
+        Device::IsTimingInput() ? L"Stop measuring" : L"Start measuring", wxDefaultPosition, wxSize(200, -1));
+    sizer->Add(myToggleButton, 0, wxALIGN_CENTER_HORIZONTAL | wxTOP, 20);
+    auto bReset = new wxButton(this, RESET_BUTTON, L"Reset", wxDefaultPosition, wxSize(200, -1));
+    sizer->Add(bReset, 0, wxALIGN_CENTER_HORIZONTAL | wxTOP, 5);
+    auto bExport = new wxButton(this, EXPORT_BUTTON, L"Export...", wxDefaultPosition, wxSize(200, -1));
+    sizer->Add(bExport, 0, wxALIGN_CENTER_HORIZONTAL | wxTOP, 5);
+
+    sizer->AddStretchSpacer();
+    SetSizer(sizer);
+}
+
+void LatencyTab::Tick()
+{
+    UpdateValues();
+}
+
+void LatencyTab::UpdateValues()
+{
+    LatencySummary summary;
+    bool isMeasuring = Device::Latency(summary);
+
+    const LatencyDistribution* rows[NUM_ROWS] =
+    {
+        &summary.pressLatency, &summary.reportInterval, &summary.reportJitter, &summary.hostInterval,
+    };
+
+    for (int row = 0; row < NUM_ROWS; ++row)
+    {
+        auto d = rows[row];
+        if (!isMeasuring || d->count == 0)
+        {
+            for (auto value : myValues[row])
+                value->SetLabel(L"-");
+            continue;
+        }
+
+        myValues[row][0]->SetLabel(wxString::Format(L"%i", d->count));
+        myValues[row][1]->SetLabel(wxString::Format(L"%.3f ms", d->p50 / 1000.0));
+        myValues[row][2]->SetLabel(wxString::Format(L"%.3f ms", d->p99 / 1000.0));
+        myValues[row][3]->SetLabel(wxString::Format(L"%.3f ms", d->max / 1000.0));
+    }
+}
+
+void LatencyTab::OnToggleMeasuring(wxCommandEvent& event)
+{
+    bool enable = !Device::IsTimingInput();
+    if (!Device::SetInputTiming(enable))
+        return;
+
+    myToggleButton->SetLabel(enable ? L"Stop measuring" : L"Start measuring");
+    UpdateValues();
+}
+
+void LatencyTab::OnReset(wxCommandEvent& event)
+{
+    Device::ResetLatency();
+    UpdateValues();
+}
+
+void LatencyTab::OnExport(wxCommandEvent& event)
+{
+    wxFileDialog dlg(this, L"Export latency", L"", L"latency", L"CSV file (*.csv)|*.csv|All files (*)|*",
+        wxFD_SAVE);
+
+    if (dlg.ShowModal() == wxID_CANCEL)
+        return;
+
+    if (!Device::ExportLatency((std::string)dlg.GetPath()))
+        Log::Writef(L"Could not export latency: %ls", dlg.GetPath().wc_str());
+}
+
+BEGIN_EVENT_TABLE(LatencyTab, wxWindow)
+    EVT_BUTTON(TOGGLE_BUTTON, LatencyTab::OnToggleMeasuring)
+    EVT_BUTTON(RESET_BUTTON, LatencyTab::OnReset)
+    EVT_BUTTON(EXPORT_BUTTON, LatencyTab::OnExport)
+END_EVENT_TABLE()
+
+}; // namespace adp.
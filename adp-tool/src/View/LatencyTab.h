@@ -0,0 +1,41 @@
+#pragma once
+
+#include "wx/window.h"
+#include "wx/button.h"
+#include "wx/stattext.h"
+
+#include "View/BaseTab.h"
+
+namespace adp {
+
+class LatencyTab : public BaseTab, public wxWindow
+{
+public:
+    static const wchar_t* Title;
+
+    LatencyTab(wxWindow* owner);
+
+    void Tick() override;
+
+    // Computing the percentiles takes a moment, so the values are not updated at the default rate.
+    int TickInterval() const override { return 250; }
+
+    void OnToggleMeasuring(wxCommandEvent& event);
+    void OnReset(wxCommandEvent& event);
+    void OnExport(wxCommandEvent& event);
+
+    wxWindow* GetWindow() override { return this; }
+
+    DECLARE_EVENT_TABLE()
+
+private:
+    static constexpr int NUM_ROWS = 4;
+    static constexpr int NUM_COLUMNS = 4;
+
+    void UpdateValues();
+
+    wxButton* myToggleButton;
+    wxStaticText* myValues[NUM_ROWS][NUM_COLUMNS];
+};
+
+}; // namespace adp.
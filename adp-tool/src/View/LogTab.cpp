@@ -1,40 +1,253 @@
 #include "Adp.h"
 
-#include "wx/sizer.h"
+#include <algorithm>
+#include <cwctype>
 
-#include "Model/Log.h"
+#include "wx/sizer.h"
+#include "wx/stattext.h"
 
 #include "View/LogTab.h"
 
+using namespace std;
+
 namespace adp {
 
 const wchar_t* LogTab::Title = L"Log";
 
+enum Columns { TIME_COLUMN, LEVEL_COLUMN, SOURCE_COLUMN, MESSAGE_COLUMN };
+
+static constexpr const wchar_t* LevelOptions[] = { L"Debug", L"Info", L"Warning", L"Error" };
+
+static constexpr const wchar_t* SOURCE_SEPARATOR = L" :: ";
+
+// Longer prefixes are part of the message, not the name of a source.
+constexpr size_t MAX_SOURCE_LENGTH = 40;
+
+static wstring ToLower(wstring text)
+{
+    transform(text.begin(), text.end(), text.begin(), [](wchar_t c) { return (wchar_t)towlower(c); });
+    return text;
+}
+
+// ====================================================================================================================
+// Log list.
+// ====================================================================================================================
+
+LogList::LogList(wxWindow* owner)
+    : wxListCtrl(owner, wxID_ANY, wxDefaultPosition, wxDefaultSize,
+        wxLC_REPORT | wxLC_VIRTUAL | wxLC_HRULES | wxBORDER_NONE)
+{
+    wxFont font = wxFont(9, wxFontFamily::wxFONTFAMILY_MODERN, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_NORMAL);
+    SetFont(font);
+
+    AppendColumn(L"Time", wxLIST_FORMAT_RIGHT, 80);
+    AppendColumn(L"Level", wxLIST_FORMAT_LEFT, 70);
+    AppendColumn(L"Source", wxLIST_FORMAT_LEFT, 170);
+    AppendColumn(L"Message", wxLIST_FORMAT_LEFT, 600);
+
+    myWarningAttr.SetTextColour(wxColour(176, 112, 0));
+    myErrorAttr.SetTextColour(wxColour(192, 0, 0));
+}
+
+void LogList::SetRows(deque<uint64_t>&& rows)
+{
+    myRows = move(rows);
+    UpdateItemCount(true);
+}
+
+void LogList::AddRows(const vector<uint64_t>& rows, uint64_t firstIndex)
+{
+    size_t numRemoved = 0;
+    while (!myRows.empty() && myRows.front() < firstIndex)
+    {
+        myRows.pop_front();
+        ++numRemoved;
+    }
+
+    if (rows.empty() && numRemoved == 0)
+        return;
+
+    bool scrollToEnd = IsShowingLastRow();
+    myRows.insert(myRows.end(), rows.begin(), rows.end());
+    UpdateItemCount(scrollToEnd);
+}
+
+bool LogList::IsShowingLastRow() const
+{
+    return GetItemCount() == 0 || GetTopItem() + GetCountPerPage() >= GetItemCount();
+}
+
+void LogList::UpdateItemCount(bool scrollToEnd)
+{
+    SetItemCount((long)myRows.size());
+    if (scrollToEnd && !myRows.empty())
+        EnsureVisible((long)myRows.size() - 1);
+    Refresh();
+}
+
+const LogMessage* LogList::RowMessage(long item) const
+{
+    if (item < 0 || item >= (long)myRows.size())
+        return nullptr;
+
+    uint64_t index = myRows[item];
+    if (!myHasMessage || myMessage.index != index)
+        myHasMessage = Log::Message(index, myMessage);
+
+    return myHasMessage ? &myMessage : nullptr;
+}
+
+wxString LogList::OnGetItemText(long item, long column) const
+{
+    auto message = RowMessage(item);
+    if (!message)
+        return wxEmptyString;
+
+    switch (column)
+    {
+    case TIME_COLUMN:
+        return wxString::Format(L"%.3f", message->time);
+    case LEVEL_COLUMN:
+        return Log::LevelName(message->level);
+    case SOURCE_COLUMN:
+        return LogTab::Source(message->text);
+    case MESSAGE_COLUMN:
+    {
+        // Rows are single lines, multi-line messages like the debug output of a pad are joined.
+        auto text = message->text;
+        auto source = LogTab::Source(text);
+        if (!source.empty())
+            text.erase(0, source.size() + wcslen(SOURCE_SEPARATOR));
+        replace(text.begin(), text.end(), L'\n', L' ');
+        return text;
+    }
+    }
+    return wxEmptyString;
+}
+
+wxListItemAttr* LogList::OnGetItemAttr(long item) const
+{
+    auto message = RowMessage(item);
+    if (message && message->level == LOG_WARNING)
+        return &myWarningAttr;
+    if (message && message->level == LOG_ERROR)
+        return &myErrorAttr;
+    return nullptr;
+}
+
+// ====================================================================================================================
+// Log tab.
+// ====================================================================================================================
+
 LogTab::LogTab(wxWindow* owner)
     : wxWindow(owner, wxID_ANY)
 {
+    auto filters = new wxBoxSizer(wxHORIZONTAL);
+
+    wxArrayString levels;
+    for (auto level : LevelOptions)
+        levels.Add(level);
+
+    myLevelChoice = new wxChoice(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, levels);
+    myLevelChoice->SetSelection(myMinLevel);
+    myLevelChoice->Bind(wxEVT_CHOICE, &LogTab::OnFilterChanged, this);
+    filters->Add(new wxStaticText(this, wxID_ANY, L"Level"), 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+    filters->Add(myLevelChoice, 0, wxALIGN_CENTER_VERTICAL);
+
+    mySourceChoice = new wxChoice(this, wxID_ANY, wxDefaultPosition, wxSize(170, -1));
+    mySourceChoice->Append(L"All");
+    mySourceChoice->SetSelection(0);
+    mySourceChoice->Bind(wxEVT_CHOICE, &LogTab::OnFilterChanged, this);
+    filters->Add(new wxStaticText(this, wxID_ANY, L"Source"), 0, wxALIGN_CENTER_VERTICAL | wxLEFT | wxRIGHT, 5);
+    filters->Add(mySourceChoice, 0, wxALIGN_CENTER_VERTICAL);
+
+    mySearch = new wxSearchCtrl(this, wxID_ANY, wxEmptyString, wxDefaultPosition, wxSize(200, -1));
+    mySearch->ShowCancelButton(true);
+    mySearch->Bind(wxEVT_TEXT, &LogTab::OnFilterChanged, this);
+    mySearch->Bind(wxEVT_SEARCHCTRL_CANCEL_BTN, &LogTab::OnSearchCancel, this);
+    filters->AddStretchSpacer();
+    filters->Add(mySearch, 0, wxALIGN_CENTER_VERTICAL);
+
+    myList = new LogList(this);
+
     auto sizer = new wxBoxSizer(wxVERTICAL);
-    myText = new wxTextCtrl(
-        this,
-        wxID_ANY,
-        wxEmptyString,
-        wxDefaultPosition,
-        wxDefaultSize,
-        wxTE_MULTILINE | wxTE_READONLY | wxBORDER_NONE);
-    wxFont font = wxFont(9, wxFontFamily::wxFONTFAMILY_MODERN, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_NORMAL);
-    myText->SetFont(font);
-    sizer->Add(myText, 1, wxEXPAND);
+    sizer->Add(filters, 0, wxEXPAND | wxALL, 5);
+    sizer->Add(myList, 1, wxEXPAND);
     SetSizer(sizer);
 }
 
 void LogTab::Tick()
 {
-    for (int numMessages = Log::NumMessages(); myNumMessages < numMessages; ++myNumMessages)
+    // Only the messages that were added since the last tick are read, the list asks for the text when it needs it.
+    vector<uint64_t> rows;
+    LogMessage message;
+    while (Log::Read(myNextMessage, message))
+    {
+        AddSource(Source(message.text));
+        if (IsShown(message))
+            rows.push_back(message.index);
+    }
+
+    myList->AddRows(rows, Log::FirstIndex());
+}
+
+wstring LogTab::Source(const wstring& text)
+{
+    auto separator = text.find(SOURCE_SEPARATOR);
+    if (separator == wstring::npos || separator > MAX_SOURCE_LENGTH)
+        return wstring();
+
+    return text.substr(0, separator);
+}
+
+bool LogTab::IsShown(const LogMessage& message) const
+{
+    if (message.level < myMinLevel)
+        return false;
+
+    if (!mySource.empty() && Source(message.text) != mySource)
+        return false;
+
+    return mySearchText.empty() || ToLower(message.text).find(mySearchText) != wstring::npos;
+}
+
+void LogTab::AddSource(const wstring& source)
+{
+    if (source.empty() || find(mySources.begin(), mySources.end(), source) != mySources.end())
+        return;
+
+    mySources.push_back(source);
+    mySourceChoice->Append(source);
+}
+
+void LogTab::OnFilterChanged(wxCommandEvent& event)
+{
+    myMinLevel = (LogLevel)max(myLevelChoice->GetSelection(), 0);
+
+    int sourceIndex = mySourceChoice->GetSelection();
+    mySource = sourceIndex > 0 ? mySources[sourceIndex - 1] : wstring();
+
+    mySearchText = ToLower(mySearch->GetValue().ToStdWstring());
+
+    Refilter();
+}
+
+void LogTab::OnSearchCancel(wxCommandEvent& event)
+{
+    // Clearing the text refilters as well.
+    mySearch->Clear();
+}
+
+void LogTab::Refilter()
+{
+    deque<uint64_t> rows;
+    LogMessage message;
+    for (uint64_t index = Log::FirstIndex(); index < myNextMessage; ++index)
     {
-        if (myNumMessages > 0)
-            myText->AppendText(L"\n");
-        myText->AppendText(Log::Message(myNumMessages));
+        if (Log::Message(index, message) && IsShown(message))
+            rows.push_back(index);
     }
+    myList->SetRows(move(rows));
 }
 
 }; // namespace adp.
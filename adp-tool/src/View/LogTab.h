@@ -1,26 +1,89 @@
 #pragma once
 
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
 #include "wx/window.h"
-#include "wx/textctrl.h"
+#include "wx/listctrl.h"
+#include "wx/choice.h"
+#include "wx/srchctrl.h"
+
+#include "Model/Log.h"
 
 #include "View/BaseTab.h"
 
 namespace adp {
 
+// Shows the log messages with the given indices. Only the rows that are visible are read from the log.
+class LogList : public wxListCtrl
+{
+public:
+    LogList(wxWindow* owner);
+
+    void SetRows(std::deque<uint64_t>&& rows);
+
+    // Adds rows at the end and drops the rows of messages older than the first index, which the log no longer has.
+    // If the last row was visible, the list scrolls along.
+    void AddRows(const std::vector<uint64_t>& rows, uint64_t firstIndex);
+
+private:
+    wxString OnGetItemText(long item, long column) const override;
+    wxListItemAttr* OnGetItemAttr(long item) const override;
+
+    const LogMessage* RowMessage(long item) const;
+    bool IsShowingLastRow() const;
+    void UpdateItemCount(bool scrollToEnd);
+
+    std::deque<uint64_t> myRows;
+
+    // Every column of a row asks for the same message, so the last one is kept.
+    mutable LogMessage myMessage;
+    mutable bool myHasMessage = false;
+
+    mutable wxListItemAttr myWarningAttr;
+    mutable wxListItemAttr myErrorAttr;
+};
+
 class LogTab : public BaseTab, public wxWindow
 {
 public:
     static const wchar_t* Title;
 
+    // New messages are picked up a few times per second, the log thread collects them every 10 ms.
+    static constexpr int LOG_TICK_INTERVAL_MS = 100;
+
     LogTab(wxWindow* owner);
 
     void Tick() override;
+    int TickInterval() const override { return LOG_TICK_INTERVAL_MS; }
+
+    void OnFilterChanged(wxCommandEvent& event);
+    void OnSearchCancel(wxCommandEvent& event);
 
     wxWindow* GetWindow() override { return this; }
 
+    // The source of a message is the part before " :: ", like "ConnectionManager". Returns an empty string if the
+    // message does not have one.
+    static std::wstring Source(const std::wstring& text);
+
 private:
-    wxTextCtrl* myText;
-    int myNumMessages = 0;
+    bool IsShown(const LogMessage& message) const;
+    void AddSource(const std::wstring& source);
+    void Refilter();
+
+    LogList* myList;
+    wxChoice* myLevelChoice;
+    wxChoice* mySourceChoice;
+    wxSearchCtrl* mySearch;
+
+    LogLevel myMinLevel = LOG_DEBUG;
+    std::wstring mySource;
+    std::wstring mySearchText;
+
+    std::vector<std::wstring> mySources;
+    uint64_t myNextMessage = 0;
 };
 
 }; // namespace adp.
@@ -5,6 +5,7 @@
 #include "wx/sizer.h"
 #include "wx/stattext.h"
 #include "wx/button.h"
+#include "wx/checkbox.h"
 
 #include "Assets/Assets.h"
 
@@ -62,7 +63,7 @@ MappingTab::MappingTab(wxWindow* owner, const PadState* pad)
     for (int i = 1; i <= pad->numButtons; ++i)
         options.Add(wxString::Format("Button %i", i));
 
-    bool configButton = Device::Pad()->featureDigipot;
+    bool configButton = Device::Pad()->featureDigipot || Device::Pad()->featureFiltering;
 
     auto sizer = new wxGridSizer(pad->numSensors, configButton ? 4 : 3, 4, 4);
     for (int i = 0; i < pad->numSensors; ++i)
@@ -141,9 +142,33 @@ SensorConfigDialog::SensorConfigDialog(int sensorNumber)
 
     auto sensor = Device::Sensor(sensorNumber);
 
-    resistorSlider = new wxSlider(this, NULL, 254 - sensor->resistorValue, 0, 254, wxDefaultPosition, wxDefaultSize);
-    resistorSlider->Bind(wxEVT_SLIDER, &SensorConfigDialog::Save, this);
-    topSizer->Add(resistorSlider, 1, wxEXPAND | wxBOTTOM, 5);
+    resistorSlider = nullptr;
+    if (Device::Pad()->featureDigipot)
+    {
+        resistorSlider = new wxSlider(this, NULL, 254 - sensor->resistorValue, 0, 254, wxDefaultPosition, wxDefaultSize);
+        resistorSlider->Bind(wxEVT_SLIDER, &SensorConfigDialog::Save, this);
+        topSizer->Add(resistorSlider, 1, wxEXPAND | wxBOTTOM, 5);
+    }
+
+    oversampleSelection = nullptr;
+    medianFilterBox = nullptr;
+    if (Device::Pad()->featureFiltering)
+    {
+        wxArrayString options;
+        options.Add("No oversampling");
+        for (int shift = 1; shift <= SensorReport::MAX_OVERSAMPLE_SHIFT; ++shift)
+            options.Add(wxString::Format("Average %i samples", 1 << shift));
+
+        oversampleSelection = new wxComboBox(this, wxID_ANY, options[sensor->oversampleShift],
+            wxDefaultPosition, wxDefaultSize, options, wxCB_READONLY);
+        oversampleSelection->Bind(wxEVT_COMBOBOX, &SensorConfigDialog::Save, this);
+        topSizer->Add(oversampleSelection, 1, wxEXPAND | wxBOTTOM, 5);
+
+        medianFilterBox = new wxCheckBox(this, wxID_ANY, L"Spike filter (median of 3)");
+        medianFilterBox->SetValue(sensor->medianFilter);
+        medianFilterBox->Bind(wxEVT_CHECKBOX, &SensorConfigDialog::Save, this);
+        topSizer->Add(medianFilterBox, 1, wxEXPAND | wxBOTTOM, 5);
+    }
 
     auto doneButton = new wxButton(this, wxID_ANY, L"Save", wxDefaultPosition, wxSize(200, -1));
     doneButton->Bind(wxEVT_BUTTON, &SensorConfigDialog::Done, this);
@@ -176,7 +201,11 @@ void SensorConfigDialog::Done(wxCommandEvent& event)
 
 void SensorConfigDialog::Save(wxCommandEvent& event)
 {
-    Device::SetAdcConfig(sensorNumber, 254 - resistorSlider->GetValue());
+    if (resistorSlider)
+        Device::SetAdcConfig(sensorNumber, 254 - resistorSlider->GetValue());
+
+    if (oversampleSelection && medianFilterBox)
+        Device::SetFilterConfig(sensorNumber, oversampleSelection->GetSelection(), medianFilterBox->GetValue());
 }
 
 }; // namespace adp.
\ No newline at end of file
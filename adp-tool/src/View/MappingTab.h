@@ -6,6 +6,7 @@
 #include "wx/window.h"
 #include "wx/dataview.h"
 #include "wx/combobox.h"
+#include "wx/checkbox.h"
 #include "wx/dialog.h"
 #include "wx/slider.h"
 #include "wx/timer.h"
@@ -25,6 +26,8 @@ public:
 
     void HandleChanges(DeviceChanges changes) override;
     void Tick() override;
+    int TickInterval() const override { return LIVE_TICK_INTERVAL_MS; }
+    bool ShowsSensorValues() const override { return true; }
 
     wxWindow* GetWindow() override { return this; }
 
@@ -51,6 +54,8 @@ private:
     HorizontalSensorBar* sensorBar;
     wxComboBox* arefSelection;
     wxSlider* resistorSlider;
+    wxComboBox* oversampleSelection;
+    wxCheckBox* medianFilterBox;
     int sensorNumber;
     wxTimer* updateTimer;
 };
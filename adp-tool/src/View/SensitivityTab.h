@@ -23,6 +23,8 @@ public:
 
     void HandleChanges(DeviceChanges changes) override;
     void Tick() override;
+    int TickInterval() const override { return LIVE_TICK_INTERVAL_MS; }
+    bool ShowsSensorValues() const override { return true; }
 
     double ReleaseThreshold() const;
 
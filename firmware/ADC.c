@@ -1,5 +1,7 @@
 #include <stdint.h>
 #include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
 
 #include "Config/DancePadConfig.h"
 #include "Pad.h"
@@ -50,6 +52,55 @@ static const uint8_t sensorToAnalogPin[SENSOR_COUNT] = {
 #endif
 };
 
+#define ADC_PIN_NONE 0b111111
+
+// different prescalers change conversion speed. tinker! 111 is slowest, and not fast enough for many sensors.
+#define ADC_PRESCALER ((1 << ADPS2) | (1 << ADPS1) | (0 << ADPS0))
+
+// Roughly how many conversions fit in a 1ms USB frame with the prescaler above.
+#define ADC_CONVERSIONS_PER_FRAME 16
+
+// Sensors that are not mapped to a button are only converted every this many scans.
+#define ADC_IDLE_SCAN_INTERVAL 16
+
+// Sensor values are double buffered. The ADC interrupt fills the back frame while the front frame always holds the
+// last complete scan over all sensors, so a reader never sees values from two different scans.
+static volatile uint16_t adcFrames[2][SENSOR_COUNT];
+static volatile uint8_t adcFrontFrame = 0;
+
+// Incremented whenever a new front frame is published.
+static volatile uint8_t adcFrameNumber = 0;
+
+// Conversions since the count was last taken, for the stats.
+static volatile uint16_t adcConversionCount = 0;
+
+// Latest filtered value of every sensor, copied into the back frame whenever a scan completes.
+static volatile uint16_t adcValues[SENSOR_COUNT];
+
+// Order in which sensors are converted, active sensors first followed by idle ones. Normal scans stop after the
+// active sensors, every ADC_IDLE_SCAN_INTERVAL scans the idle sensors are included.
+static uint8_t adcScanOrder[SENSOR_COUNT];
+static uint8_t adcActiveCount = 0;
+static uint8_t adcScanCount = 0;
+
+// Extra oversampling for active sensors, spending the conversions that fewer active sensors leave unused. It applies
+// to every active sensor, also the ones configured without oversampling. An average keeps the scale of the values.
+static uint8_t adcExtraShift = 0;
+
+// Position of the conversion in progress within adcScanOrder, and the length of the current scan.
+static uint8_t adcScanIndex = 0;
+static uint8_t adcScanLength = 0;
+static uint8_t adcScanNumber = 0;
+
+typedef struct {
+    uint16_t history[3]; // last raw samples, newest first
+    uint16_t sum;
+    uint8_t count;
+} SensorFilter;
+
+// Only touched from the ADC interrupt, or with interrupts disabled.
+static SensorFilter adcFilters[SENSOR_COUNT];
+
 void ADC_LoadPot(uint8_t sensor) {
 	SensorConfig s = PAD_CONF.sensors[sensor];
 	
@@ -108,31 +159,59 @@ void ADC_LoadPot(uint8_t sensor) {
 	#endif
 }
 
-void ADC_Init(void) {
-    // different prescalers change conversion speed. tinker! 111 is slowest, and not fast enough for many sensors.
-    const uint8_t prescaler = (1 << ADPS2) | (1 << ADPS1) | (0 << ADPS0);
+static uint16_t ADC_Median3(uint16_t a, uint16_t b, uint16_t c) {
+    if (a > b) {
+        uint16_t t = a; a = b; b = t;
+    }
 
-    ADCSRA = (1 << ADEN) | prescaler;
-    ADMUX = (1 << REFS0);
-    ADCSRB = (1 << ADHSM); // enable high speed mode
+    // a <= b, so the median is b unless c lies below it.
+    if (c < b) {
+        return c > a ? c : a;
+    }
 
-	// Muxer outputs
-	DDRD |= (1 << DDD0) | (1 << DDD1);
-	DDRC |= 1 << DDC6;
-	DDRE |= 1 << DDE6;
-	
-	#if defined(FEATURE_DIGIPOT_ENABLED)
-		DDRB |= (1 << DDB6) | (1 << DDB2) | (1 << DDB1); //spi pins on port b SS, MOSI, SCK outputs
-		SPCR = (1 << SPE) | (1 << MSTR);  // SPI enable, Master
-	#endif
+    return b;
 }
 
-uint16_t ADC_Read(uint8_t sensor) {
+static void ADC_ResetFilters(void) {
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        adcFilters[i].history[0] = 0;
+        adcFilters[i].history[1] = 0;
+        adcFilters[i].history[2] = 0;
+        adcFilters[i].sum = 0;
+        adcFilters[i].count = 0;
+    }
+}
+
+// Feeds one raw sample through the filter of a sensor. Once enough samples are accumulated, their average becomes
+// the new sensor value.
+static void ADC_FilterSample(uint8_t sensor, uint16_t sample, uint8_t extraShift) {
+    SensorFilter* filter = &adcFilters[sensor];
+    uint16_t flags = PAD_CONF.sensors[sensor].flags;
+
+    if (flags & ADC_MEDIAN_FILTER) {
+        // Median of the last three samples rejects single sample spikes.
+        filter->history[2] = filter->history[1];
+        filter->history[1] = filter->history[0];
+        filter->history[0] = sample;
+        sample = ADC_Median3(filter->history[0], filter->history[1], filter->history[2]);
+    }
+
+    uint8_t shift = ((flags & ADC_OVERSAMPLE_SHIFT_MASK) >> ADC_OVERSAMPLE_SHIFT_OFFSET) + extraShift;
+    if (shift > ADC_MAX_OVERSAMPLE_SHIFT) {
+        shift = ADC_MAX_OVERSAMPLE_SHIFT;
+    }
+
+    filter->sum += sample;
+    if (++filter->count >= (1 << shift)) {
+        adcValues[sensor] = filter->sum >> shift;
+        filter->sum = 0;
+        filter->count = 0;
+    }
+}
+
+static void ADC_StartConversion(uint8_t sensor) {
     uint8_t pin = sensorToAnalogPin[sensor];
-	if(pin == 0b111111) {
-		return 0;
-	}
-	
+
 	#if defined(FEATURE_DIGIPOT_ENABLED)
 		ADC_LoadPot(sensor);
 	#endif
@@ -142,7 +221,152 @@ uint16_t ADC_Read(uint8_t sensor) {
 	ADCSRB = (ADCSRB & 0xDF) | (pin & 0x20);   //select channel (MUX5 bit) 
 	
 	ADCSRA |= (1 << ADSC); // start conversion
-	while (ADCSRA & (1 << ADSC)) {}; // wait until done
-		
-    return ADC;
+}
+
+bool ADC_IsConnected(uint8_t sensor) {
+    return sensor < SENSOR_COUNT && sensorToAnalogPin[sensor] != ADC_PIN_NONE;
+}
+
+// Aborts the conversion in progress and starts a new scan from the first sensor. Interrupts must be disabled.
+static void ADC_RestartScan(void) {
+    ADCSRA = (1 << ADIF); // disabling the ADC aborts the conversion, writing ADIF clears a pending completion
+    ADCSRA = (1 << ADEN) | (1 << ADIE) | ADC_PRESCALER; // conversion complete interrupt drives the scan
+
+    adcScanIndex = 0;
+    adcScanNumber = 0;
+    adcScanLength = adcActiveCount > 0 ? adcActiveCount : adcScanCount;
+
+    if (adcScanLength > 0) {
+        ADC_StartConversion(adcScanOrder[0]);
+    }
+}
+
+void ADC_Init(void) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        // Stop a scan that may still be running from a previous initialization, it restarts once sensors are set.
+        ADCSRA = (1 << ADIF);
+
+        adcActiveCount = 0;
+        adcScanCount = 0;
+
+        for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+            adcFrames[0][i] = 0;
+            adcFrames[1][i] = 0;
+            adcValues[i] = 0;
+        }
+
+        ADC_ResetFilters();
+
+        ADMUX = (1 << REFS0);
+        ADCSRB = (1 << ADHSM); // enable high speed mode
+
+        // Muxer outputs
+        DDRD |= (1 << DDD0) | (1 << DDD1);
+        DDRC |= 1 << DDC6;
+        DDRE |= 1 << DDE6;
+        
+        #if defined(FEATURE_DIGIPOT_ENABLED)
+            DDRB |= (1 << DDB6) | (1 << DDB2) | (1 << DDB1); //spi pins on port b SS, MOSI, SCK outputs
+            SPCR = (1 << SPE) | (1 << MSTR);  // SPI enable, Master
+        #endif
+    }
+}
+
+// Sets the sensors to scan. Active sensors are converted every scan, idle sensors only once in a while. Sensors in
+// neither list are not converted at all and read as zero. Filter settings may have changed too, so partially
+// accumulated samples are dropped instead of mixing them with new settings.
+void ADC_SetSensors(const uint8_t* activeSensors, uint8_t activeCount, const uint8_t* idleSensors, uint8_t idleCount) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        adcScanCount = 0;
+
+        for (uint8_t i = 0; i < activeCount && adcScanCount < SENSOR_COUNT; i++) {
+            adcScanOrder[adcScanCount++] = activeSensors[i];
+        }
+
+        adcActiveCount = adcScanCount;
+
+        for (uint8_t i = 0; i < idleCount && adcScanCount < SENSOR_COUNT; i++) {
+            adcScanOrder[adcScanCount++] = idleSensors[i];
+        }
+
+        // Fewer active sensors leave room for more conversions of each within a frame.
+        adcExtraShift = 0;
+        while (adcActiveCount > 0 &&
+               adcExtraShift < ADC_MAX_OVERSAMPLE_SHIFT &&
+               (adcActiveCount << (adcExtraShift + 1)) <= ADC_CONVERSIONS_PER_FRAME) {
+            adcExtraShift++;
+        }
+
+        for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+            adcValues[i] = 0;
+        }
+
+        for (uint8_t i = 0; i < adcScanCount; i++) {
+            uint8_t sensor = adcScanOrder[i];
+            adcValues[sensor] = adcFrames[adcFrontFrame][sensor];
+        }
+
+        ADC_ResetFilters();
+        ADC_RestartScan();
+    }
+}
+
+// Changes whenever a new complete scan is available.
+uint8_t ADC_FrameNumber(void) {
+    return adcFrameNumber;
+}
+
+// Copies the last complete scan of all sensors. Unconnected sensors read as zero.
+void ADC_ReadFrame(uint16_t* sensorValues) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        const volatile uint16_t* frame = adcFrames[adcFrontFrame];
+
+        for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+            sensorValues[i] = frame[i];
+        }
+    }
+}
+
+// Returns the number of conversions since the last call and starts counting again.
+uint16_t ADC_TakeConversionCount(void) {
+    uint16_t count;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        count = adcConversionCount;
+        adcConversionCount = 0;
+    }
+
+    return count;
+}
+
+ISR(ADC_vect) {
+    uint8_t index = adcScanIndex;
+
+    adcConversionCount++;
+
+    ADC_FilterSample(adcScanOrder[index], ADC, index < adcActiveCount ? adcExtraShift : 0);
+
+    // At the end of a scan the latest values are published through the back frame, which then becomes the new front
+    // frame.
+    if (++index >= adcScanLength) {
+        uint8_t backFrame = adcFrontFrame ^ 1;
+
+        for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+            adcFrames[backFrame][i] = adcValues[i];
+        }
+
+        adcFrontFrame = backFrame;
+        adcFrameNumber++;
+
+        index = 0;
+        if (adcActiveCount > 0 && ++adcScanNumber < ADC_IDLE_SCAN_INTERVAL) {
+            adcScanLength = adcActiveCount;
+        } else {
+            adcScanNumber = 0;
+            adcScanLength = adcScanCount;
+        }
+    }
+
+    adcScanIndex = index;
+    ADC_StartConversion(adcScanOrder[index]);
 }
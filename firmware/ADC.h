@@ -1,7 +1,12 @@
 #ifndef _ADC_H_
 #define _ADC_H_
     #include <stdint.h>
+    #include <stdbool.h>
     
     void ADC_Init(void);
-    uint16_t ADC_Read(uint8_t channel);
+    bool ADC_IsConnected(uint8_t sensor);
+    void ADC_SetSensors(const uint8_t* activeSensors, uint8_t activeCount, const uint8_t* idleSensors, uint8_t idleCount);
+    uint8_t ADC_FrameNumber(void);
+    void ADC_ReadFrame(uint16_t* sensorValues);
+    uint16_t ADC_TakeConversionCount(void);
 #endif
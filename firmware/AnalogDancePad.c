@@ -29,15 +29,30 @@
 
 #include "Config/DancePadConfig.h"
 #include "AnalogDancePad.h"
+#include "Clock.h"
 #include "Communication.h"
 #include "Descriptors.h"
 #include "Pad.h"
 #include "Reset.h"
 #include "Lights.h"
 #include "Debug.h"
+#include "Stats.h"
 
 static Configuration configuration;
 
+// Where the next config block read starts.
+static uint16_t configBlockOffset = 0;
+
+// Light rules and led mappings follow each other in the light configuration, so the config block maps onto two
+// stretches of memory.
+static uint8_t* ConfigBlock_Address(uint16_t offset)
+{
+    if (offset < CONFIG_BLOCK_LIGHTS_OFFSET)
+        return (uint8_t*)configuration.padConfiguration.sensors + offset;
+
+    return (uint8_t*)configuration.lightConfiguration.lightRules + (offset - CONFIG_BLOCK_LIGHTS_OFFSET);
+}
+
 /** Buffer to hold the previously generated HID report, for comparison purposes inside the HID class driver. */
 static uint8_t PrevHIDReportBuffer[GENERIC_EPSIZE];
 
@@ -73,8 +88,21 @@ int main(void)
 
     for (;;)
     {
+        uint32_t loopStart = Clock_Micros();
+
+        // Keep a fresh input report ready ahead of the next host poll.
+        Communication_StageInputHIDReport();
+
         HID_Device_USBTask(&Generic_HID_Interface);
         USB_USBTask();
+
+        // Lights are not latency critical, they are updated between USB frames.
+        Lights_Task();
+
+        ConfigStore_Task();
+
+        Stats_Task();
+        Stats_Record(STATS_MAIN_LOOP, loopStart);
     }
 }
 
@@ -101,6 +129,7 @@ void SetupHardware(void)
 #endif
 
     /* Hardware Initialization */
+    Clock_Init();
     USB_Init();
 }
 
@@ -110,11 +139,19 @@ void SetupConfiguration()
     Lights_UpdateConfiguration(&configuration.lightConfiguration);
 }
 
+/** Event handler for the library USB Reset event. A host that asked for streams before is gone. */
+void EVENT_USB_Device_Reset(void)
+{
+    Communication_ResetHostStreams();
+}
+
 /** Event handler for the library USB Configuration Changed event. */
 void EVENT_USB_Device_ConfigurationChanged(void)
 {
     HID_Device_ConfigureEndpoints(&Generic_HID_Interface);
     USB_Device_EnableSOFEvents();
+    Communication_ResetInputStatistics();
+    Communication_ResetHostStreams();
 }
 
 /** Event handler for the library USB Control Request reception event. */
@@ -148,10 +185,49 @@ bool CALLBACK_HID_Device_CreateHIDReport(
 {
     if (*ReportID == 0)
     {
-        // no report id requested - write button and sensor data
-        Communication_WriteInputHIDReport(ReportData);
-        *ReportID = INPUT_REPORT_ID;
-        *ReportSize = sizeof (InputHIDReport);
+        // button changes always go out first in a compact report, the only one the OS reads buttons from, so games keep
+        // working while a host streams sensor values.
+        if (Communication_HasCompactButtonChange())
+        {
+            Communication_WriteInputCompactHIDReport(ReportData);
+            *ReportID = INPUT_COMPACT_REPORT_ID;
+            *ReportSize = sizeof (InputCompactHIDReport);
+            return true;
+        }
+
+#if defined(FEATURE_DEBUG_ENABLED)
+        // pending debug text takes at most every other input report, so input keeps flowing while a debug build talks.
+        static bool sentDebugStream = false;
+        if (Communication_IsDebugStreamEnabled() && !sentDebugStream && Debug_Available() > 0)
+        {
+            Communication_WriteDebugStreamHIDReport(ReportData);
+            *ReportID = DEBUG_STREAM_REPORT_ID;
+            *ReportSize = sizeof (DebugStreamHIDReport);
+            sentDebugStream = true;
+            return true;
+        }
+        sentDebugStream = false;
+#endif
+
+        // no button change to send - write sensor data if a host asked for it, with timestamps while measuring latency
+        if (Communication_IsAnalogStreamEnabled() && Communication_IsInputTimingEnabled())
+        {
+            Communication_WriteInputTimedHIDReport(ReportData);
+            *ReportID = INPUT_TIMED_REPORT_ID;
+            *ReportSize = sizeof (InputTimedHIDReport);
+        }
+        else if (Communication_IsAnalogStreamEnabled())
+        {
+            Communication_WriteInputHIDReport(ReportData);
+            *ReportID = INPUT_REPORT_ID;
+            *ReportSize = sizeof (InputHIDReport);
+        }
+        else
+        {
+            Communication_WriteInputCompactHIDReport(ReportData);
+            *ReportID = INPUT_COMPACT_REPORT_ID;
+            *ReportSize = sizeof (InputCompactHIDReport);
+        }
     }
     else if (*ReportID == PAD_CONFIGURATION_REPORT_ID)
     {
@@ -197,6 +273,11 @@ bool CALLBACK_HID_Device_CreateHIDReport(
 		
 		Debug_Message("Welcome V2!\n");
     }
+    else if (*ReportID == IDENTIFICATION_V3_REPORT_ID)
+    {
+        Communication_WriteIdentificationV3Report(ReportData);
+        *ReportSize = sizeof(IdentificationV3FeatureReport);
+    }
     else if (*ReportID == LED_MAPPING_REPORT_ID)
     {
         LedMappingHIDReport* report = ReportData;
@@ -216,24 +297,35 @@ bool CALLBACK_HID_Device_CreateHIDReport(
         else
             memset(&report->sensor, 0, sizeof(SensorConfig));
         *ReportSize = sizeof(SensorHIDReport);
+    }
+    else if (*ReportID == CONFIG_BLOCK_REPORT_ID)
+    {
+        ConfigBlockHIDReport* report = ReportData;
+        uint16_t offset = configBlockOffset < CONFIG_BLOCK_SIZE ? configBlockOffset : CONFIG_BLOCK_SIZE;
+        uint16_t length = CONFIG_BLOCK_SIZE - offset;
+        if (length > CONFIG_BLOCK_DATA_SIZE)
+            length = CONFIG_BLOCK_DATA_SIZE;
+
+        memset(report, 0, sizeof(ConfigBlockHIDReport));
+        report->offset = offset;
+        report->length = length;
+        for (uint8_t i = 0; i < length; i++)
+            report->data[i] = *ConfigBlock_Address(offset + i);
+
+        configBlockOffset = offset + length;
+        *ReportSize = sizeof(ConfigBlockHIDReport);
+    }
+    else if (*ReportID == STATS_REPORT_ID)
+    {
+        Communication_WriteStatsReport(ReportData);
+        *ReportSize = sizeof(StatsFeatureReport);
     }
 	#if defined(FEATURE_DEBUG_ENABLED)
 	else if (*ReportID == DEBUG_REPORT_ID)
     {
         DebugHIDReport* report = ReportData;
 		
-		uint16_t readSize = Debug_Available();
-		uint16_t maxReadSize = sizeof(report->messagePacket);
-		
-		if(readSize > 0) {
-			if(readSize > maxReadSize) {
-				readSize = maxReadSize;
-			}
-			
-			report->messageSize = readSize;
-			Debug_ReadBuffer(&report->messagePacket, readSize);
-		}
-		
+		report->messageSize = Debug_ReadBuffer(report->messagePacket, sizeof(report->messagePacket));
         *ReportSize = sizeof(DebugHIDReport);
     }
 	#endif
@@ -267,11 +359,15 @@ void CALLBACK_HID_Device_ProcessHIDReport(USB_ClassInfo_HID_Device_t* const HIDI
     }
     else if (ReportID == RESET_REPORT_ID)
     {
+        // finish a save in progress, it would be lost otherwise. a failing eeprom does not keep the pad from resetting.
+        ConfigStore_FinishSave();
+
         Reset_JumpToBootloader();
     }
     else if (ReportID == SAVE_CONFIGURATION_REPORT_ID)
     {
-        ConfigStore_StoreConfiguration(&configuration);
+        // written from the main loop, a byte at a time.
+        ConfigStore_RequestSave(&configuration);
     }
     else if (ReportID == FACTORY_RESET_REPORT_ID)
     {
@@ -316,6 +412,21 @@ void CALLBACK_HID_Device_ProcessHIDReport(USB_ClassInfo_HID_Device_t* const HIDI
             Pad_UpdateConfiguration(&configuration.padConfiguration);
         }
     }
+    else if (ReportID == CONFIG_BLOCK_REPORT_ID && ReportSize == sizeof(ConfigBlockHIDReport))
+    {
+        const ConfigBlockHIDReport* report = ReportData;
+        if (report->length <= CONFIG_BLOCK_DATA_SIZE && report->offset + report->length <= CONFIG_BLOCK_SIZE)
+        {
+            for (uint8_t i = 0; i < report->length; i++)
+                *ConfigBlock_Address(report->offset + i) = report->data[i];
+
+            if (report->offset < CONFIG_BLOCK_LIGHTS_OFFSET)
+                Pad_UpdateConfiguration(&configuration.padConfiguration);
+
+            if (report->offset + report->length > CONFIG_BLOCK_LIGHTS_OFFSET)
+                Lights_UpdateConfiguration(&configuration.lightConfiguration);
+        }
+    }
     else if (ReportID == SET_PROPERTY_REPORT_ID && ReportSize == sizeof (SetPropertyHIDReport))
     {
         const SetPropertyHIDReport* report = ReportData;
@@ -332,6 +443,28 @@ void CALLBACK_HID_Device_ProcessHIDReport(USB_ClassInfo_HID_Device_t* const HIDI
         case SPID_SELECTED_SENSOR_INDEX:
             PAD_CONF.selectedSensorIndex = (uint8_t)report->propertyValue;
             break;
+
+        case SPID_ANALOG_STREAM:
+            Communication_SetAnalogStream(report->propertyValue != 0);
+            break;
+
+        case SPID_CONFIG_BLOCK_OFFSET:
+            configBlockOffset = (uint16_t)report->propertyValue;
+            break;
+
+        case SPID_INPUT_TIMING:
+            Communication_SetInputTiming(report->propertyValue != 0);
+            break;
+
+        case SPID_RESET_STATS:
+            Stats_Reset();
+            break;
+
+#if defined(FEATURE_DEBUG_ENABLED)
+        case SPID_DEBUG_STREAM:
+            Communication_SetDebugStream(report->propertyValue != 0);
+            break;
+#endif
         }
     }
 }
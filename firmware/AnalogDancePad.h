@@ -44,6 +44,7 @@
 
         void EVENT_USB_Device_Connect(void);
         void EVENT_USB_Device_Disconnect(void);
+        void EVENT_USB_Device_Reset(void);
         void EVENT_USB_Device_ConfigurationChanged(void);
         void EVENT_USB_Device_ControlRequest(void);
         void EVENT_USB_Device_StartOfFrame(void);
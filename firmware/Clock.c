@@ -0,0 +1,37 @@
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+#include "Clock.h"
+
+// Upper 16 bits of the tick count, timer 1 holds the lower 16 bits.
+static volatile uint16_t clockOverflows = 0;
+
+void Clock_Init(void) {
+    // normal mode, counting up from 0 to 0xFFFF
+    TCCR1A = 0;
+    TCCR1B = (1 << CS11) | (1 << CS10);
+    TIMSK1 = (1 << TOIE1);
+}
+
+uint32_t Clock_Micros(void) {
+    uint16_t overflows;
+    uint16_t ticks;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        overflows = clockOverflows;
+        ticks = TCNT1;
+
+        // The timer may have wrapped after interrupts were disabled, then the overflow is still pending.
+        if ((TIFR1 & (1 << TOV1)) && ticks < 0x8000) {
+            overflows++;
+        }
+    }
+
+    return (((uint32_t)overflows << 16) | ticks) * CLOCK_TICK_US;
+}
+
+ISR(TIMER1_OVF_vect) {
+    clockOverflows++;
+}
@@ -0,0 +1,11 @@
+#ifndef _CLOCK_H_
+#define _CLOCK_H_
+    #include <stdint.h>
+
+    // Timer 1 runs with a prescaler of 64, every tick is this many microseconds.
+    #define CLOCK_TICK_US (64000000UL / F_CPU)
+
+    // Free-running microsecond clock, it wraps around after about 71 minutes.
+    void Clock_Init(void);
+    uint32_t Clock_Micros(void);
+#endif
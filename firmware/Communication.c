@@ -1,28 +1,178 @@
 #include <stdbool.h>
+#include <string.h>
+#include <LUFA/Drivers/USB/USB.h>
 
 #include "Config/DancePadConfig.h"
 #include "Communication.h"
 #include "Pad.h"
 #include "Lights.h"
+#include "ADC.h"
+#include "Clock.h"
+#include "Stats.h"
+
+// USB frame numbers are 11 bits and wrap around every 2048ms.
+#define FRAME_NUMBER_MASK 0x7FF
+#define FRAMES_PER_SECOND 1000
 
 const char boardType[] = BOARD_TYPE;
 
-void Communication_WriteInputHIDReport(InputHIDReport* report) {
-    // first, update pad state
-    Pad_UpdateState();
+// Input report for the next host poll, kept up to date from the main loop.
+static InputHIDReport stagedInputReport;
+static uint16_t stagedButtonChangeTimes[BUTTON_COUNT];
+static uint8_t stagedAdcFrame;
+
+typedef struct {
+    bool hasReported;
+    uint16_t lastReportFrame;
+    uint16_t windowStartFrame;
+    uint16_t reportsInWindow;
+    uint16_t reportRate;
+    uint32_t missedFrames;
+} InputStatistics;
+
+static InputStatistics inputStatistics;
+
+// Sensor values are only sent while a host asks for them, otherwise the pad sends compact button-only reports.
+static bool analogStreamEnabled = false;
+
+// Only the compact report declares buttons to the OS, so while streaming a compact report is sent whenever the buttons
+// differ from the ones it last carried.
+static uint8_t compactButtons[CEILING(BUTTON_COUNT, 8)];
+
+// Sensor value reports carry timestamps while a host is measuring latency.
+static bool inputTimingEnabled = false;
 
-    // write buttons to the report
-    for (int i = 0; i < BUTTON_COUNT; i++) {
-        // trol https://stackoverflow.com/a/47990
-        report->buttons[i / 8] ^= (-PAD_STATE.buttonsPressed[i] ^ report->buttons[i / 8]) & (1UL << i % 8);
+#if defined(FEATURE_DEBUG_ENABLED)
+// Debug text is sent in between input reports while a host asks for it.
+static bool debugStreamEnabled = false;
+#endif
+
+// Updates the staged input report when the ADC has completed a new scan. Called from the main loop so that creating
+// the report when the host polls is only a copy.
+void Communication_StageInputHIDReport(void) {
+    uint8_t adcFrame = ADC_FrameNumber();
+
+    if (adcFrame != stagedAdcFrame) {
+        stagedAdcFrame = adcFrame;
+
+        uint32_t updateStart = Clock_Micros();
+        Pad_UpdateState();
+        Stats_Record(STATS_PAD_UPDATE, updateStart);
+
+        // write buttons to the report
+        for (int i = 0; i < BUTTON_COUNT; i++) {
+            // trol https://stackoverflow.com/a/47990
+            stagedInputReport.buttons[i / 8] ^= (-PAD_STATE.buttonsPressed[i] ^ stagedInputReport.buttons[i / 8]) & (1UL << i % 8);
+        }
+       
+        // write sensor values to the report
+        for (int i = 0; i < SENSOR_COUNT; i++) {
+            stagedInputReport.sensorValues[i] = PAD_STATE.sensorValues[i];
+        }
+
+        memcpy(stagedButtonChangeTimes, PAD_STATE.buttonChangeTimes, sizeof (stagedButtonChangeTimes));
     }
-   
-    // write sensor values to the report
-    for (int i = 0; i < SENSOR_COUNT; i++) {
-        report->sensorValues[i] = PAD_STATE.sensorValues[i];
+
+    // Close the report rate window once a second, also when the host stopped polling altogether.
+    uint16_t frame = USB_Device_GetFrameNumber();
+    if (((frame - inputStatistics.windowStartFrame) & FRAME_NUMBER_MASK) >= FRAMES_PER_SECOND) {
+        inputStatistics.reportRate = inputStatistics.reportsInWindow;
+        inputStatistics.reportsInWindow = 0;
+        inputStatistics.windowStartFrame = frame;
     }
 }
 
+// Called when the host (re)configures the device, frames before that are not missed.
+void Communication_ResetInputStatistics(void) {
+    inputStatistics.hasReported = false;
+    inputStatistics.reportsInWindow = 0;
+    inputStatistics.windowStartFrame = USB_Device_GetFrameNumber();
+}
+
+// Turns off everything a host may have asked for, so the pad is back to compact reports after a reset or reconnect.
+void Communication_ResetHostStreams(void) {
+    analogStreamEnabled = false;
+    inputTimingEnabled = false;
+#if defined(FEATURE_DEBUG_ENABLED)
+    debugStreamEnabled = false;
+#endif
+}
+
+void Communication_SetAnalogStream(bool enabled) {
+    analogStreamEnabled = enabled;
+}
+
+bool Communication_IsAnalogStreamEnabled(void) {
+    return analogStreamEnabled;
+}
+
+void Communication_SetInputTiming(bool enabled) {
+    inputTimingEnabled = enabled;
+}
+
+bool Communication_IsInputTimingEnabled(void) {
+    return inputTimingEnabled;
+}
+
+#if defined(FEATURE_DEBUG_ENABLED)
+void Communication_SetDebugStream(bool enabled) {
+    debugStreamEnabled = enabled;
+}
+
+bool Communication_IsDebugStreamEnabled(void) {
+    return debugStreamEnabled;
+}
+#endif
+
+// Every input report takes the frame, including debug stream reports, so those do not count as missed frames.
+static void Communication_TrackReportFrame(void) {
+    // An input report is created at most once per frame, any frame skipped since the last one was missed.
+    uint16_t frame = USB_Device_GetFrameNumber();
+    if (inputStatistics.hasReported) {
+        uint16_t elapsed = (frame - inputStatistics.lastReportFrame) & FRAME_NUMBER_MASK;
+        if (elapsed > 1) {
+            inputStatistics.missedFrames += elapsed - 1;
+        }
+    }
+
+    inputStatistics.hasReported = true;
+    inputStatistics.lastReportFrame = frame;
+}
+
+static void Communication_CountInputReport(void) {
+    Communication_TrackReportFrame();
+    inputStatistics.reportsInWindow++;
+}
+
+#if defined(FEATURE_DEBUG_ENABLED)
+void Communication_WriteDebugStreamHIDReport(DebugStreamHIDReport* report) {
+    report->length = (uint8_t)Debug_ReadBuffer(report->data, DEBUG_STREAM_DATA_SIZE);
+    Communication_TrackReportFrame();
+}
+#endif
+
+void Communication_WriteInputHIDReport(InputHIDReport* report) {
+    memcpy(report, &stagedInputReport, sizeof (InputHIDReport));
+    Communication_CountInputReport();
+}
+
+void Communication_WriteInputTimedHIDReport(InputTimedHIDReport* report) {
+    memcpy(&report->input, &stagedInputReport, sizeof (InputHIDReport));
+    memcpy(report->buttonChangeTimes, stagedButtonChangeTimes, sizeof (report->buttonChangeTimes));
+    report->reportTime = Clock_Micros();
+    Communication_CountInputReport();
+}
+
+bool Communication_HasCompactButtonChange(void) {
+    return memcmp(compactButtons, stagedInputReport.buttons, sizeof (compactButtons)) != 0;
+}
+
+void Communication_WriteInputCompactHIDReport(InputCompactHIDReport* report) {
+    memcpy(report->buttons, stagedInputReport.buttons, sizeof (report->buttons));
+    memcpy(compactButtons, stagedInputReport.buttons, sizeof (compactButtons));
+    Communication_CountInputReport();
+}
+
 void Communication_WriteIdentificationReport(IdentificationFeatureReport* ReportData) {
     ReportData->firmwareVersionMajor = FIRMWARE_VERSION_MAJOR;
     ReportData->firmwareVersionMinor = FIRMWARE_VERSION_MINOR;
@@ -42,6 +192,7 @@ void Communication_WriteIdentificationV2Report(IdentificationV2FeatureReport* Re
 	ReportData->features = 0;
 	#if defined(FEATURE_DEBUG_ENABLED)
 		ReportData->features |= FEATURE_DEBUG;
+		ReportData->features |= FEATURE_DEBUG_STREAM;
 	#endif
 	
 	#if defined(FEATURE_DIGIPOT_ENABLED)
@@ -51,4 +202,21 @@ void Communication_WriteIdentificationV2Report(IdentificationV2FeatureReport* Re
 	#if defined(FEATURE_LIGHTS_ENABLED)
 		ReportData->features |= FEATURE_LIGHTS;
 	#endif
-}
\ No newline at end of file
+	
+	ReportData->features |= FEATURE_FILTERING;
+	ReportData->features |= FEATURE_STATS;
+}
+
+void Communication_WriteIdentificationV3Report(IdentificationV3FeatureReport* ReportData) {
+	Communication_WriteIdentificationV2Report(&ReportData->parent);
+	
+	ReportData->reportRate = inputStatistics.reportRate;
+	ReportData->missedFrames = inputStatistics.missedFrames;
+}
+
+void Communication_WriteStatsReport(StatsFeatureReport* ReportData) {
+	Stats_ReadStages(ReportData->stages);
+	ReportData->adcConversionsPerSecond = Stats_AdcConversionsPerSecond();
+	ReportData->reportRate = inputStatistics.reportRate;
+	ReportData->missedFrames = inputStatistics.missedFrames;
+}
@@ -8,6 +8,7 @@
 	#include "ADC.h"
     #include "ConfigStore.h"
 	#include "Debug.h"
+    #include "Stats.h"
 
     // small helper macro to do x / y, but rounded up instead of floored.
     #define CEILING(x,y) (((x) + (y) - 1) / (y))
@@ -22,6 +23,20 @@
         uint16_t sensorValues[SENSOR_COUNT];
     } __attribute__((packed)) InputHIDReport;
 
+    typedef struct {
+        uint8_t buttons[CEILING(BUTTON_COUNT, 8)];
+    } __attribute__((packed)) InputCompactHIDReport;
+
+    // The input report with timestamps from Clock_Micros, so the host can measure latency on the pad. The report time
+    // is taken when the report is handed to USB. Button change times are the lower 16 bits of the time a button was
+    // last pressed or released, they are only meaningful for changes in the last 65 milliseconds.
+    // Together with the report id this just fits in GENERIC_EPSIZE.
+    typedef struct {
+        InputHIDReport input;
+        uint32_t reportTime;
+        uint16_t buttonChangeTimes[BUTTON_COUNT];
+    } __attribute__((packed)) InputTimedHIDReport;
+
     //
     // FEATURE REPORTS
     // ie. can be requested by computer and written by computer
@@ -54,6 +69,11 @@
     #define SPID_SELECTED_LIGHT_RULE_INDEX  0
     #define SPID_SELECTED_LED_MAPPING_INDEX 1
     #define SPID_SELECTED_SENSOR_INDEX 2
+    #define SPID_ANALOG_STREAM 3
+    #define SPID_CONFIG_BLOCK_OFFSET 4
+    #define SPID_INPUT_TIMING 5
+    #define SPID_DEBUG_STREAM 6
+    #define SPID_RESET_STATS 7
 
     typedef struct {
         uint32_t propertyId;
@@ -75,15 +95,69 @@
 		uint16_t features;
     } __attribute__((packed)) IdentificationV2FeatureReport;
 	
+	typedef struct {
+		IdentificationV2FeatureReport parent;
+		uint16_t reportRate; // input reports per second taken by the host
+		uint32_t missedFrames; // USB frames without an input report since power up
+    } __attribute__((packed)) IdentificationV3FeatureReport;
+	
+	
+	// Performance counters, see Stats.h. Times are in microseconds. Writing SPID_RESET_STATS clears the maximums.
+	typedef struct {
+		StageStats stages[STATS_STAGE_COUNT];
+		uint16_t adcConversionsPerSecond;
+		uint16_t reportRate; // input reports per second taken by the host
+		uint32_t missedFrames; // USB frames without an input report since power up
+	} __attribute__((packed)) StatsFeatureReport;
+	
+	// The config block is a flat view of the sensor, light rule and led mapping tables, so a host can read and write all
+	// of them in a few transfers. Reading continues where the previous read ended, starting at the offset set through
+	// SPID_CONFIG_BLOCK_OFFSET.
+	#define CONFIG_BLOCK_LIGHTS_OFFSET (SENSOR_COUNT * sizeof (SensorConfig))
+	#define CONFIG_BLOCK_SIZE (CONFIG_BLOCK_LIGHTS_OFFSET + MAX_LIGHT_RULES * sizeof (LightRule) + MAX_LED_MAPPINGS * sizeof (LedMapping))
+	#define CONFIG_BLOCK_DATA_SIZE 58
+	
+	typedef struct {
+		uint16_t offset;
+		uint8_t length;
+		uint8_t data[CONFIG_BLOCK_DATA_SIZE];
+	} __attribute__((packed)) ConfigBlockHIDReport;
 	
 	#if defined(FEATURE_DEBUG_ENABLED)
 		typedef struct {
 			uint16_t messageSize;
 			char messagePacket[32];
 		} DebugHIDReport;
+		
+		// Debug text sent as an input report while the host asks for it through SPID_DEBUG_STREAM, so it does not
+		// have to poll DebugHIDReport. Together with the report id this fills GENERIC_EPSIZE.
+		#define DEBUG_STREAM_DATA_SIZE 62
+		
+		typedef struct {
+			uint8_t length;
+			char data[DEBUG_STREAM_DATA_SIZE];
+		} __attribute__((packed)) DebugStreamHIDReport;
 	#endif
 	
+    void Communication_StageInputHIDReport(void);
+    void Communication_ResetInputStatistics(void);
+    void Communication_ResetHostStreams(void);
+    void Communication_SetAnalogStream(bool enabled);
+    bool Communication_IsAnalogStreamEnabled(void);
+    void Communication_SetInputTiming(bool enabled);
+    bool Communication_IsInputTimingEnabled(void);
     void Communication_WriteInputHIDReport(InputHIDReport* report);
+    void Communication_WriteInputTimedHIDReport(InputTimedHIDReport* report);
+    bool Communication_HasCompactButtonChange(void);
+    void Communication_WriteInputCompactHIDReport(InputCompactHIDReport* report);
     void Communication_WriteIdentificationReport(IdentificationFeatureReport* report);
     void Communication_WriteIdentificationV2Report(IdentificationV2FeatureReport* report);
+    void Communication_WriteIdentificationV3Report(IdentificationV3FeatureReport* report);
+    void Communication_WriteStatsReport(StatsFeatureReport* report);
+	
+	#if defined(FEATURE_DEBUG_ENABLED)
+		void Communication_SetDebugStream(bool enabled);
+		bool Communication_IsDebugStreamEnabled(void);
+		void Communication_WriteDebugStreamHIDReport(DebugStreamHIDReport* report);
+	#endif
 #endif
@@ -2,11 +2,14 @@
 #define _DANCE_PAD_CONFIG_H_
     //Version 2 since Kauhsa's initial version will be considered version 0
     #define FIRMWARE_VERSION_MAJOR 1
-    #define FIRMWARE_VERSION_MINOR 3
+    #define FIRMWARE_VERSION_MINOR 5
 
 	#define FEATURE_DEBUG 1 << 0
 	#define FEATURE_DIGIPOT 1 << 1
 	#define FEATURE_LIGHTS 1 << 2
+	#define FEATURE_FILTERING 1 << 3
+	#define FEATURE_DEBUG_STREAM 1 << 4
+	#define FEATURE_STATS 1 << 5
 	
 	//#define FEATURE_DEBUG_ENABLED
 	//#define FEATURE_DIGIPOT_ENABLED
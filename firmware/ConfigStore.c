@@ -1,21 +1,133 @@
 #include <string.h>
 #include <stdint.h>
+#include <stddef.h>
 #include <util/atomic.h>
+#include <util/crc16.h>
+#include <avr/io.h>
 #include <avr/eeprom.h>
 
 #include "Config/DancePadConfig.h"
 #include "Pad.h"
 #include "ConfigStore.h"
+#include "Clock.h"
+#include "Stats.h"
 
 // just some random bytes to figure out what we have in eeprom
 // change these to reset configuration!
-static const uint8_t magicBytes[5] = {9, 74, 9, FIRMWARE_VERSION_MAJOR, FIRMWARE_VERSION_MINOR};
+static const uint8_t magicBytes[5] = {9, 74, 10, FIRMWARE_VERSION_MAJOR, FIRMWARE_VERSION_MINOR};
 
 // where magic bytes (which indicate that a pad configuration is, in fact, stored) exist
-#define MAGIC_BYTES_ADDRESS ((void *) 0x00)
+#define MAGIC_BYTES_ADDRESS ((uint8_t *) 0x00)
 
-// where actual configration is stored
-#define CONFIGURATION_ADDRESS ((void *) (MAGIC_BYTES_ADDRESS + sizeof (magicBytes)))
+// The configuration is stored in sections, so that a change only rewrites the section it is in. Every section has
+// two slots that are written in turn. A slot starts with a header holding a sequence number and a CRC of its data, the
+// slot with the newest sequence number and a matching CRC is the valid one. The header is written after the data, so
+// an interrupted write leaves the previous slot valid.
+typedef struct {
+    uint16_t crc;
+    uint8_t sequence;
+} __attribute__((packed)) SlotHeader;
+
+typedef struct {
+    uint16_t offset; // in Configuration
+    uint16_t size;
+} Section;
+
+static const Section sections[] = {
+    { offsetof(Configuration, padConfiguration), sizeof (PadConfigurationV2) },
+    { offsetof(Configuration, nameAndSize), sizeof (NameAndSize) },
+    { offsetof(Configuration, lightConfiguration), sizeof (LightConfiguration) },
+};
+
+#define SECTION_COUNT (sizeof (sections) / sizeof (Section))
+#define SLOT_COUNT 2
+
+#define SECTIONS_ADDRESS (MAGIC_BYTES_ADDRESS + sizeof (magicBytes))
+
+_Static_assert(
+    sizeof (magicBytes) + SLOT_COUNT * (SECTION_COUNT * sizeof (SlotHeader) + sizeof (Configuration)) <= E2END + 1,
+    "configuration slots do not fit in eeprom"
+);
+
+// Stores that find the eeprom byte they would write unchanged move on to the next byte, up to this many per task.
+#define MAX_COMPARES_PER_TASK 16
+
+// A section whose slot does not read back what was written is tried in the other slot, then given up on until the
+// next save request, instead of rewriting a worn out slot forever.
+#define MAX_FAILED_WRITES SLOT_COUNT
+
+// Upper bound for a blocking save, enough to write every byte of every slot once. An eeprom byte write takes 3.4ms.
+#define STORE_TIMEOUT_US (SLOT_COUNT * (sizeof (magicBytes) + SECTION_COUNT * sizeof (SlotHeader) + sizeof (Configuration)) * 4000UL)
+
+typedef struct {
+    bool stored;       // a valid slot exists
+    uint8_t validSlot; // slot holding the stored data
+    uint8_t sequence;  // sequence number of the stored data
+    uint16_t crc;      // crc of the stored data
+    uint8_t failedWrites; // writes that did not verify since the last save request
+} SectionState;
+
+static SectionState sectionStates[SECTION_COUNT];
+
+// Write in progress. The data is written first, then the header, magic bytes are written before any section.
+typedef enum {
+    STORE_IDLE,
+    STORE_MAGIC,
+    STORE_DATA,
+    STORE_HEADER,
+    STORE_VERIFY
+} StoreStep;
+
+static struct {
+    const Configuration* conf;
+    uint8_t pendingSections; // bit per section that may have changed since it was stored
+    bool magicStored;
+    StoreStep step;
+    uint8_t section;
+    uint8_t slot;
+    SlotHeader header;
+    uint16_t position;
+    bool writing; // an eeprom byte write was started at writeStart and may still be in progress
+    uint32_t writeStart;
+} store;
+
+static uint8_t* ConfigStore_SlotAddress(uint8_t section, uint8_t slot) {
+    uint8_t* address = SECTIONS_ADDRESS;
+
+    for (uint8_t i = 0; i < section; i++) {
+        address += SLOT_COUNT * (sizeof (SlotHeader) + sections[i].size);
+    }
+
+    return address + slot * (sizeof (SlotHeader) + sections[section].size);
+}
+
+static uint16_t ConfigStore_Crc(const uint8_t* data, uint16_t size) {
+    uint16_t crc = 0xFFFF;
+
+    for (uint16_t i = 0; i < size; i++) {
+        crc = _crc_ccitt_update(crc, data[i]);
+    }
+
+    return crc;
+}
+
+static uint16_t ConfigStore_EepromCrc(const uint8_t* address, uint16_t size) {
+    uint16_t crc = 0xFFFF;
+
+    for (uint16_t i = 0; i < size; i++) {
+        crc = _crc_ccitt_update(crc, eeprom_read_byte(address + i));
+    }
+
+    return crc;
+}
+
+// Returns true if the slot holds data matching its header.
+static bool ConfigStore_ReadSlotHeader(uint8_t section, uint8_t slot, SlotHeader* header) {
+    const uint8_t* address = ConfigStore_SlotAddress(section, slot);
+
+    eeprom_read_block(header, address, sizeof (SlotHeader));
+    return ConfigStore_EepromCrc(address + sizeof (SlotHeader), sections[section].size) == header->crc;
+}
 
 #if defined(BOARD_TYPE_FSRMINIPAD)
 	#define DEFAULT_NAME "FSR Mini pad"
@@ -127,26 +239,215 @@ static const Configuration DEFAULT_CONFIGURATION = {
 };
 
 void ConfigStore_LoadConfiguration(Configuration* conf) {
-    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
-        // see if we have magic bytes stored
-        uint8_t magicByteBuffer[sizeof (magicBytes)];
-        eeprom_read_block(magicByteBuffer, MAGIC_BYTES_ADDRESS, sizeof (magicBytes));
-
-        if (memcmp(magicByteBuffer, magicBytes, sizeof (magicBytes)) == 0) {
-            // we had magic bytes, let's load the configuration!
-            eeprom_read_block(conf, CONFIGURATION_ADDRESS, sizeof (Configuration));
-        } else {
-            // we had some garbage on magic byte address, let's just use the default configuration
-            ConfigStore_FactoryDefaults(conf);
+    // start from the defaults, so sections without a valid slot have sensible values.
+    ConfigStore_FactoryDefaults(conf);
+
+    memset(&store, 0, sizeof (store));
+    memset(sectionStates, 0, sizeof (sectionStates));
+
+    // see if we have magic bytes stored
+    uint8_t magicByteBuffer[sizeof (magicBytes)];
+    eeprom_read_block(magicByteBuffer, MAGIC_BYTES_ADDRESS, sizeof (magicBytes));
+
+    if (memcmp(magicByteBuffer, magicBytes, sizeof (magicBytes)) != 0) {
+        // we had some garbage on magic byte address, let's just use the default configuration
+        return;
+    }
+
+    store.magicStored = true;
+
+    for (uint8_t section = 0; section < SECTION_COUNT; section++) {
+        SectionState* state = &sectionStates[section];
+
+        for (uint8_t slot = 0; slot < SLOT_COUNT; slot++) {
+            SlotHeader header;
+
+            if (!ConfigStore_ReadSlotHeader(section, slot, &header)) {
+                continue;
+            }
+
+            // sequence numbers wrap around, the newer one is less than half the range ahead.
+            if (!state->stored || (int8_t)(header.sequence - state->sequence) > 0) {
+                state->stored = true;
+                state->validSlot = slot;
+                state->sequence = header.sequence;
+                state->crc = header.crc;
+            }
+        }
+
+        if (state->stored) {
+            eeprom_read_block(
+                (uint8_t*)conf + sections[section].offset,
+                ConfigStore_SlotAddress(section, state->validSlot) + sizeof (SlotHeader),
+                sections[section].size
+            );
         }
     }
 }
 
-void ConfigStore_StoreConfiguration(const Configuration* conf) {
-    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
-        eeprom_update_block(conf, CONFIGURATION_ADDRESS, sizeof (Configuration));
-        eeprom_update_block(magicBytes, MAGIC_BYTES_ADDRESS, sizeof (magicBytes));
+// Schedules storing all sections that changed. The configuration must stay valid, it is read while writing.
+void ConfigStore_RequestSave(const Configuration* conf) {
+    store.conf = conf;
+    store.pendingSections = (1 << SECTION_COUNT) - 1;
+
+    for (uint8_t section = 0; section < SECTION_COUNT; section++) {
+        sectionStates[section].failedWrites = 0;
+    }
+}
+
+bool ConfigStore_IsSaving(void) {
+    return store.pendingSections != 0 || store.step != STORE_IDLE;
+}
+
+// Writes a byte unless eeprom already holds it. Returns true if a write was started.
+static bool ConfigStore_UpdateByte(uint8_t* address, uint8_t value) {
+    if (eeprom_read_byte(address) == value) {
+        return false;
+    }
+
+    eeprom_write_byte(address, value);
+    store.writing = true;
+    store.writeStart = Clock_Micros();
+    return true;
+}
+
+static void ConfigStore_FinishSection(void) {
+    SectionState* state = &sectionStates[store.section];
+    uint16_t writtenCrc = store.header.crc;
+
+    // read back what was written. the section is checked again, the recheck finds it unchanged.
+    if (ConfigStore_ReadSlotHeader(store.section, store.slot, &store.header)) {
+        state->stored = true;
+        state->validSlot = store.slot;
+        state->sequence = store.header.sequence;
+        state->crc = store.header.crc;
+        state->failedWrites = 0;
+        store.pendingSections |= 1 << store.section;
+    }
+    // if the configuration changed while writing, the data may not match the header. write the new data.
+    else if (ConfigStore_Crc((const uint8_t*)store.conf + sections[store.section].offset, sections[store.section].size) != writtenCrc) {
+        store.pendingSections |= 1 << store.section;
     }
+    // otherwise the slot did not take the data. try the other slot, then leave the section as it is.
+    else if (++state->failedWrites < MAX_FAILED_WRITES) {
+        store.pendingSections |= 1 << store.section;
+    }
+
+    store.step = STORE_IDLE;
+}
+
+// Picks the next pending section that changed since it was stored. Returns false if there is none.
+static bool ConfigStore_StartSection(void) {
+    while (store.pendingSections) {
+        uint8_t section = 0;
+        while (!(store.pendingSections & (1 << section))) {
+            section++;
+        }
+
+        store.pendingSections &= ~(1 << section);
+
+        const SectionState* state = &sectionStates[section];
+        uint16_t crc = ConfigStore_Crc((const uint8_t*)store.conf + sections[section].offset, sections[section].size);
+
+        if (state->stored && state->crc == crc) {
+            continue;
+        }
+
+        // after a failed write the next slot is used, this may overwrite the valid slot.
+        store.section = section;
+        store.slot = ((state->stored ? state->validSlot + 1 : 0) + state->failedWrites) % SLOT_COUNT;
+        store.header.crc = crc;
+        store.header.sequence = state->sequence + 1;
+        store.position = 0;
+        store.step = store.magicStored ? STORE_DATA : STORE_MAGIC;
+        return true;
+    }
+
+    return false;
+}
+
+// Called from the main loop. Writes at most one eeprom byte per call and never waits for the eeprom, so storing the
+// configuration does not hold up USB or input handling.
+void ConfigStore_Task(void) {
+    if (!eeprom_is_ready()) {
+        return;
+    }
+
+    // this includes the time until the main loop got back here, not just the write itself. see STATS_EEPROM_WRITE.
+    if (store.writing) {
+        store.writing = false;
+        Stats_Record(STATS_EEPROM_WRITE, store.writeStart);
+    }
+
+    if (store.step == STORE_IDLE && !ConfigStore_StartSection()) {
+        return;
+    }
+
+    for (uint8_t compares = 0; compares < MAX_COMPARES_PER_TASK; compares++) {
+        bool written = false;
+
+        if (store.step == STORE_MAGIC) {
+            written = ConfigStore_UpdateByte(MAGIC_BYTES_ADDRESS + store.position, magicBytes[store.position]);
+
+            if (++store.position == sizeof (magicBytes)) {
+                store.magicStored = true;
+                store.position = 0;
+                store.step = STORE_DATA;
+            }
+        }
+        else if (store.step == STORE_DATA) {
+            const uint8_t* data = (const uint8_t*)store.conf + sections[store.section].offset;
+            uint8_t* address = ConfigStore_SlotAddress(store.section, store.slot) + sizeof (SlotHeader);
+
+            written = ConfigStore_UpdateByte(address + store.position, data[store.position]);
+
+            if (++store.position == sections[store.section].size) {
+                store.position = 0;
+                store.step = STORE_HEADER;
+            }
+        }
+        else if (store.step == STORE_HEADER) {
+            const uint8_t* header = (const uint8_t*)&store.header;
+            uint8_t* address = ConfigStore_SlotAddress(store.section, store.slot);
+
+            written = ConfigStore_UpdateByte(address + store.position, header[store.position]);
+
+            if (++store.position == sizeof (SlotHeader)) {
+                // the last header byte may still be in progress, verify once the eeprom is ready.
+                store.position = 0;
+                store.step = STORE_VERIFY;
+            }
+        }
+        else if (store.step == STORE_VERIFY) {
+            ConfigStore_FinishSection();
+            return;
+        }
+
+        if (written) {
+            return;
+        }
+    }
+}
+
+// Finishes a save in progress before returning, or gives up after STORE_TIMEOUT_US. Returns true if it finished.
+bool ConfigStore_FinishSave(void) {
+    uint32_t start = Clock_Micros();
+
+    while (ConfigStore_IsSaving()) {
+        if (Clock_Micros() - start > STORE_TIMEOUT_US) {
+            return false;
+        }
+
+        ConfigStore_Task();
+    }
+
+    return true;
+}
+
+// Stores all changed sections before returning.
+bool ConfigStore_StoreConfiguration(const Configuration* conf) {
+    ConfigStore_RequestSave(conf);
+    return ConfigStore_FinishSave();
 }
 
 void ConfigStore_FactoryDefaults (Configuration* conf) {
@@ -17,6 +17,10 @@
     } __attribute__((packed)) Configuration;
 	
     void ConfigStore_LoadConfiguration(Configuration* conf);
-    void ConfigStore_StoreConfiguration(const Configuration* conf);
+    void ConfigStore_RequestSave(const Configuration* conf);
+    bool ConfigStore_IsSaving(void);
+    void ConfigStore_Task(void);
+    bool ConfigStore_FinishSave(void);
+    bool ConfigStore_StoreConfiguration(const Configuration* conf);
     void ConfigStore_FactoryDefaults(Configuration* conf);
 #endif
@@ -3,45 +3,56 @@
 
 #if defined(FEATURE_DEBUG_ENABLED)
 
+// Must be a power of two of at most 128, so the free running 8 bit indices below wrap around with the buffer.
 #define DEBUG_BUFFER_SIZE 128
+#define DEBUG_BUFFER_MASK (DEBUG_BUFFER_SIZE - 1)
 
-char debugBuffer [DEBUG_BUFFER_SIZE];
-volatile uint16_t debugBufferAvailable = 0;
+static char debugBuffer [DEBUG_BUFFER_SIZE];
 
-void Debug_MoveBuffer(uint16_t position) {
-	debugBufferAvailable -= position;
-	memcpy(debugBuffer, debugBuffer + position, debugBufferAvailable);
-}
+// Messages are written at the head and read at the tail. Both only count up, the difference is the number of bytes in
+// the buffer. Only Debug_Message moves the head and only Debug_ReadBuffer moves the tail, so nothing is ever moved.
+static volatile uint8_t debugHead = 0;
+static volatile uint8_t debugTail = 0;
 
 void Debug_Message(const char* message) {
-	uint16_t freeBufferSpace = DEBUG_BUFFER_SIZE - debugBufferAvailable;
-	uint16_t readLength = strlen(message);
-	if(readLength > freeBufferSpace) {
-		readLength = freeBufferSpace;
+	uint8_t head = debugHead;
+	uint8_t freeBufferSpace = DEBUG_BUFFER_SIZE - (uint8_t)(head - debugTail);
+	
+	// Whatever does not fit is dropped.
+	while(*message && freeBufferSpace > 0) {
+		debugBuffer[head & DEBUG_BUFFER_MASK] = *message++;
+		head++;
+		freeBufferSpace--;
 	}
 	
-	memcpy(debugBuffer + debugBufferAvailable, message, readLength);
-	debugBufferAvailable += readLength;
+	debugHead = head;
 }
 
-void Debug_ReadBuffer(char* target, uint16_t length) {
-	if(length > debugBufferAvailable) {
-		length = debugBufferAvailable;
+uint16_t Debug_ReadBuffer(char* target, uint16_t length) {
+	uint8_t tail = debugTail;
+	uint8_t available = debugHead - tail;
+	if(length > available) {
+		length = available;
+	}
+	
+	for(uint16_t i = 0; i < length; i++) {
+		target[i] = debugBuffer[tail & DEBUG_BUFFER_MASK];
+		tail++;
 	}
 	
-	memcpy(target, debugBuffer, length);
-	Debug_MoveBuffer(length);
+	debugTail = tail;
+	return length;
 }
 
 uint16_t Debug_Available() {
-	return debugBufferAvailable;
+	return (uint8_t)(debugHead - debugTail);
 }
 
 #else
 
 void Debug_Init() {;}
 void Debug_Message(const char* message) {;}
-void Debug_ReadBuffer(char* target, uint16_t length) {;}
+uint16_t Debug_ReadBuffer(char* target, uint16_t length) { return 0; }
 uint16_t Debug_Available() { return 0; }
 
-#endif
\ No newline at end of file
+#endif
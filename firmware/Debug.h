@@ -4,7 +4,7 @@
 #include <stdint.h>
 
 void Debug_Message(const char* message);
-void Debug_ReadBuffer(char* target, uint16_t length);
+uint16_t Debug_ReadBuffer(char* target, uint16_t length); // returns the number of bytes read
 uint16_t Debug_Available();
 
 #endif
\ No newline at end of file
@@ -39,7 +39,9 @@ const USB_Descriptor_HIDReport_Datatype_t PROGMEM GenericReport[] =
     HID_RI_USAGE_PAGE(8, 0x01),
     HID_RI_USAGE(8, 0x04),
     HID_RI_COLLECTION(8, 0x01),
-        HID_RI_REPORT_ID(8, INPUT_REPORT_ID),
+        // buttons only, sent unless analog streaming is enabled. this is the only report that declares the buttons:
+        // hosts drop or duplicate buttons that are declared twice in one collection.
+        HID_RI_REPORT_ID(8, INPUT_COMPACT_REPORT_ID),
         HID_RI_USAGE_PAGE(8, 0x09),
         HID_RI_USAGE_MINIMUM(8, 0x01),
         HID_RI_USAGE_MAXIMUM(8, BUTTON_COUNT),
@@ -49,6 +51,24 @@ const USB_Descriptor_HIDReport_Datatype_t PROGMEM GenericReport[] =
         HID_RI_REPORT_COUNT(8, BUTTON_COUNT),
         HID_RI_INPUT(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE),
         // TODO: padding here if BUTTON_COUNT not divisible by 8
+
+        // buttons and sensor values for the configuration tool, sent instead of the compact report while analog
+        // streaming is enabled. the button bits are vendor data here, for the reason above.
+        HID_RI_REPORT_ID(8, INPUT_REPORT_ID),
+        HID_RI_USAGE_PAGE(16, 0xFF00), // vendor usage page
+        HID_RI_USAGE(8, 0x01),
+        HID_RI_COLLECTION(8, 0x00),
+            HID_RI_USAGE(8, 0x01),
+            HID_RI_LOGICAL_MINIMUM(8, 0x00),
+            HID_RI_LOGICAL_MAXIMUM(8, 0xFF),
+            HID_RI_REPORT_SIZE(8, 0x08),
+            HID_RI_REPORT_COUNT(8, sizeof (InputHIDReport)),
+            HID_RI_INPUT(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE),
+        HID_RI_END_COLLECTION(0),
+
+        // same as the input report above, followed by timestamps. sent instead of it while input timing is enabled.
+        // all of it is vendor data, like the input report.
+        HID_RI_REPORT_ID(8, INPUT_TIMED_REPORT_ID),
         HID_RI_USAGE_PAGE(16, 0xFF00), // vendor usage page
         HID_RI_USAGE(8, 0x01),
         HID_RI_COLLECTION(8, 0x00),
@@ -56,7 +76,7 @@ const USB_Descriptor_HIDReport_Datatype_t PROGMEM GenericReport[] =
             HID_RI_LOGICAL_MINIMUM(8, 0x00),
             HID_RI_LOGICAL_MAXIMUM(8, 0xFF),
             HID_RI_REPORT_SIZE(8, 0x08),
-            HID_RI_REPORT_COUNT(8, SENSOR_COUNT * 2),
+            HID_RI_REPORT_COUNT(8, sizeof (InputTimedHIDReport)),
             HID_RI_INPUT(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE),
         HID_RI_END_COLLECTION(0),
 
@@ -190,6 +210,19 @@ const USB_Descriptor_HIDReport_Datatype_t PROGMEM GenericReport[] =
 				HID_RI_REPORT_COUNT(8, sizeof(DebugHIDReport)),
 				HID_RI_FEATURE(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE | HID_IOF_NON_VOLATILE),
 			HID_RI_END_COLLECTION(0),
+			
+			// same text as the debug report above, sent in between input reports while the host enables it.
+			HID_RI_REPORT_ID(8, DEBUG_STREAM_REPORT_ID),
+			HID_RI_USAGE_PAGE(16, 0xFF00), // vendor usage page
+			HID_RI_USAGE(8, 0x01),
+			HID_RI_COLLECTION(8, 0x00),
+				HID_RI_USAGE(8, 0x01),
+				HID_RI_LOGICAL_MINIMUM(8, 0x00),
+				HID_RI_LOGICAL_MAXIMUM(8, 0xFF),
+				HID_RI_REPORT_SIZE(8, 0x08),
+				HID_RI_REPORT_COUNT(8, sizeof(DebugStreamHIDReport)),
+				HID_RI_INPUT(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE),
+			HID_RI_END_COLLECTION(0),
 		#endif
 		
 		HID_RI_REPORT_ID(8, IDENTIFICATION_V2_REPORT_ID),
@@ -204,6 +237,42 @@ const USB_Descriptor_HIDReport_Datatype_t PROGMEM GenericReport[] =
 			HID_RI_FEATURE(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE | HID_IOF_NON_VOLATILE),
 		HID_RI_END_COLLECTION(0),
 
+		HID_RI_REPORT_ID(8, IDENTIFICATION_V3_REPORT_ID),
+		HID_RI_USAGE_PAGE(16, 0xFF00), // vendor usage page
+		HID_RI_USAGE(8, 0x02),
+		HID_RI_COLLECTION(8, 0x00),
+			HID_RI_USAGE(8, 0x02),
+			HID_RI_LOGICAL_MINIMUM(8, 0x00),
+			HID_RI_LOGICAL_MAXIMUM(8, 0xFF),
+			HID_RI_REPORT_SIZE(8, 0x08),
+			HID_RI_REPORT_COUNT(8, sizeof(IdentificationV3FeatureReport)),
+			HID_RI_FEATURE(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE | HID_IOF_NON_VOLATILE),
+		HID_RI_END_COLLECTION(0),
+
+		HID_RI_REPORT_ID(8, CONFIG_BLOCK_REPORT_ID),
+		HID_RI_USAGE_PAGE(16, 0xFF00), // vendor usage page
+		HID_RI_USAGE(8, 0x02),
+		HID_RI_COLLECTION(8, 0x00),
+			HID_RI_USAGE(8, 0x02),
+			HID_RI_LOGICAL_MINIMUM(8, 0x00),
+			HID_RI_LOGICAL_MAXIMUM(8, 0xFF),
+			HID_RI_REPORT_SIZE(8, 0x08),
+			HID_RI_REPORT_COUNT(8, sizeof(ConfigBlockHIDReport)),
+			HID_RI_FEATURE(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE | HID_IOF_NON_VOLATILE),
+		HID_RI_END_COLLECTION(0),
+
+		HID_RI_REPORT_ID(8, STATS_REPORT_ID),
+		HID_RI_USAGE_PAGE(16, 0xFF00), // vendor usage page
+		HID_RI_USAGE(8, 0x02),
+		HID_RI_COLLECTION(8, 0x00),
+			HID_RI_USAGE(8, 0x02),
+			HID_RI_LOGICAL_MINIMUM(8, 0x00),
+			HID_RI_LOGICAL_MAXIMUM(8, 0xFF),
+			HID_RI_REPORT_SIZE(8, 0x08),
+			HID_RI_REPORT_COUNT(8, sizeof(StatsFeatureReport)),
+			HID_RI_FEATURE(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE | HID_IOF_NON_VOLATILE),
+		HID_RI_END_COLLECTION(0),
+
     HID_RI_END_COLLECTION(0)
 };
 
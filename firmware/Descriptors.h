@@ -84,9 +84,15 @@
 		
 		#if defined(FEATURE_DEBUG_ENABLED)
 			#define DEBUG_REPORT_ID      	     0xD
+			#define DEBUG_STREAM_REPORT_ID       0x13
 		#endif
 		
 		#define IDENTIFICATION_V2_REPORT_ID      0xE
+		#define IDENTIFICATION_V3_REPORT_ID      0xF
+		#define INPUT_COMPACT_REPORT_ID          0x10
+		#define CONFIG_BLOCK_REPORT_ID           0x11
+		#define INPUT_TIMED_REPORT_ID            0x12
+		#define STATS_REPORT_ID                  0x14
 
     /* Macros: */
         /** Endpoint address of the Generic HID reporting IN endpoint. */
@@ -2,16 +2,23 @@
 #include <avr/interrupt.h>
 #include <util/delay.h>
 #include <stdint.h>
+#include <string.h>
+#include <LUFA/Drivers/USB/USB.h>
 #include "Pad.h"
 #include "Lights.h"
+#include "Clock.h"
+#include "Stats.h"
 
 LightConfiguration LIGHT_CONF;
 
 #if defined(FEATURE_LIGHTS_ENABLED)
 
 
-// Skip every x amount of light updates to improve polling rate
-#define UPDATE_WAIT_CYCLES 10
+// Lights are updated every this many USB frames (milliseconds).
+#define UPDATE_INTERVAL_FRAMES 10
+
+// USB frame numbers are 11 bits and wrap around every 2048ms.
+#define FRAME_NUMBER_MASK 0x7FF
 
 #if defined(BOARD_TYPE_FSRIO_1)
 	#define LED_STRIP_PORT PORTB
@@ -83,105 +90,201 @@ void __attribute__((noinline)) led_strip_write(rgb_color * colors, uint16_t coun
           "I" (LED_STRIP_PIN)     // %3 is the pin number (0-8)
     );
 
-    // Uncomment the line below to temporarily enable interrupts between each color.
-    //sei(); asm volatile("nop\n"); cli();
+    // Interrupts stay masked for the whole strip. An ADC or USB interrupt between colors can take longer than the
+    // low time that latches the strip, which would show a torn frame. The write takes about 30us per LED and runs
+    // from the main loop every UPDATE_INTERVAL_FRAMES, off the report path, interrupts that come in are serviced after.
   }
   sei();          // Re-enable interrupts now that we are done.
 }
 
+// Fades are quantised to this many steps, so small sensor changes do not cause a new color.
+#define FADE_STEP_BITS 6
+#define FADE_STEPS (1 << FADE_STEP_BITS)
+
+// Set in a fade key when the sensor is above its threshold, the fade step is in the lower bits.
+#define FADE_KEY_ON 0x100
+#define FADE_KEY_NONE 0xFFFF
+
+// Everything needed to render a mapping, precalculated when the configuration changes.
+typedef struct
+{
+	bool enabled;
+	uint8_t ledIndexBegin;
+	uint8_t ledIndexEnd;
+	uint16_t threshold;
+	uint32_t fadeScale; // turns a sensor value distance of up to threshold into a fade step, FADE_STEPS << 16 / threshold
+	uint16_t fadeKey;   // on state and fade step the color was last rendered for
+	rgb_color color;
+} MappingState;
+
+static MappingState MAPPING_STATE[MAX_LED_MAPPINGS];
+
+// Colors last written to the strip.
 static rgb_color LED_COLORS[LED_COUNT];
 
-long map(long x, long in_min, long in_max, long out_min, long out_max) {
-  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+// Forces the next update to write the strip, even if no color changed.
+static bool forceWrite = true;
+static uint16_t lastSeenFrame = 0;
+static uint16_t lastUpdateFrame = 0;
+
+void Lights_UpdateThresholds(void) {
+	for (uint8_t m = 0; m < MAX_LED_MAPPINGS; ++m)
+	{
+		const LedMapping* mapping = &LIGHT_CONF.ledMappings[m];
+		MappingState* state = &MAPPING_STATE[m];
+		
+		state->enabled =
+			(mapping->flags & LMF_ENABLED) &&
+			mapping->lightRuleIndex < MAX_LIGHT_RULES &&
+			mapping->sensorIndex < SENSOR_COUNT &&
+			(LIGHT_CONF.lightRules[mapping->lightRuleIndex].flags & LRF_ENABLED);
+		
+		state->ledIndexBegin = mapping->ledIndexBegin;
+		state->ledIndexEnd = mapping->ledIndexEnd > LED_COUNT ? LED_COUNT : mapping->ledIndexEnd;
+		
+		state->threshold = state->enabled ? PAD_CONF.sensors[mapping->sensorIndex].threshold : 0;
+		state->fadeScale = state->threshold > 0 ? ((uint32_t)FADE_STEPS << 16) / state->threshold : 0;
+		state->fadeKey = FADE_KEY_NONE;
+	}
+	
+	forceWrite = true;
 }
 
 void Lights_UpdateConfiguration(const LightConfiguration* lightConfiguration) {
     memcpy(&LIGHT_CONF, lightConfiguration, sizeof (LightConfiguration));
-	Lights_Update(true);
+	Lights_UpdateThresholds();
 }
 
-int updateWait = 0;
-
-void Lights_Update(bool force)
+// Fade step for a sensor value that is the given distance into a fade, the fade ends at the threshold distance.
+static uint8_t Lights_FadeStep(const MappingState* state, uint16_t distance)
 {
-	if(updateWait > 0 && !force) {
-		updateWait --;
-		return;
+	if (distance >= state->threshold) {
+		return FADE_STEPS;
 	}
 	
-	for (uint8_t led = 0; led < LED_COUNT; ++led) {
-		LED_COLORS[led] = (rgb_color) {0, 0, 0};
+	return (uint8_t)((distance * state->fadeScale) >> 16);
+}
+
+static uint16_t Lights_FadeKey(const MappingState* state, const LightRule* rule, uint16_t sensorValue)
+{
+	if (sensorValue > state->threshold) {
+		if (rule->flags & LRF_FADE_ON) {
+			return FADE_KEY_ON | Lights_FadeStep(state, sensorValue - state->threshold);
+		}
+		
+		return FADE_KEY_ON;
 	}
 	
-	updateWait = UPDATE_WAIT_CYCLES;
-	bool update = false;
+	if (rule->flags & LRF_FADE_OFF) {
+		return Lights_FadeStep(state, sensorValue);
+	}
 	
-	for (uint8_t m = 0; m < MAX_LED_MAPPINGS; ++m)
-	{
-        const LedMapping* mapping = &LIGHT_CONF.ledMappings[m];
+	return 0;
+}
 
-        if (!(mapping->flags & LMF_ENABLED))
-            continue;
+static uint8_t Lights_Fade(uint8_t from, uint8_t to, uint8_t step)
+{
+	return from + ((((int16_t)to - from) * step) >> FADE_STEP_BITS);
+}
 
-        const LightRule* rule = &LIGHT_CONF.lightRules[mapping->lightRuleIndex];
+static rgb_color Lights_FadeColor(rgb_color from, rgb_color to, uint8_t step)
+{
+	return (rgb_color) {
+		Lights_Fade(from.red,   to.red,   step),
+		Lights_Fade(from.green, to.green, step),
+		Lights_Fade(from.blue,  to.blue,  step)
+	};
+}
 
-        if (!(rule->flags & LRF_ENABLED))
-            continue;
-			
-		update = true;
+// Renders the mappings whose sensor moved to another fade step since the last update. Returns true when any color
+// changed.
+static bool Lights_Render(void)
+{
+	bool changed = false;
+	
+	for (uint8_t m = 0; m < MAX_LED_MAPPINGS; ++m)
+	{
+		MappingState* state = &MAPPING_STATE[m];
 		
-		SensorConfig s = PAD_CONF.sensors[mapping->sensorIndex];
-		uint16_t sensorValue = PAD_STATE.sensorValues[mapping->sensorIndex];
-		uint16_t sensorThreshold = s.threshold;
+		if (!state->enabled)
+			continue;
 		
-		bool sensorState = sensorValue > sensorThreshold;
+		const LedMapping* mapping = &LIGHT_CONF.ledMappings[m];
+		const LightRule* rule = &LIGHT_CONF.lightRules[mapping->lightRuleIndex];
+		uint16_t fadeKey = Lights_FadeKey(state, rule, PAD_STATE.sensorValues[mapping->sensorIndex]);
 		
+		if (fadeKey == state->fadeKey)
+			continue;
+		
+		state->fadeKey = fadeKey;
+		
+		uint8_t step = fadeKey & ~FADE_KEY_ON;
 		rgb_color color;
 		
-		if(sensorState == true) {
-			if(rule->flags & LRF_FADE_ON) {
-				uint16_t sensorThreshold2 = sensorThreshold * 2;
-				
-				if(sensorValue <= sensorThreshold2) {				
-					color = (rgb_color) {	
-						map(sensorValue, sensorThreshold, sensorThreshold2, rule->onColor.red,   rule->onFadeColor.red),
-						map(sensorValue, sensorThreshold, sensorThreshold2, rule->onColor.green, rule->onFadeColor.green),
-						map(sensorValue, sensorThreshold, sensorThreshold2, rule->onColor.blue,  rule->onFadeColor.blue)
-					};
-				}
-				else {
-					color = rule->onFadeColor;
-				}
-			}
-			else {
-				color = rule->onColor;
-			}
+		if (fadeKey & FADE_KEY_ON) {
+			color = (rule->flags & LRF_FADE_ON) ? Lights_FadeColor(rule->onColor, rule->onFadeColor, step) : rule->onColor;
 		}
 		else {
-			if(rule->flags & LRF_FADE_OFF) {
-				color = (rgb_color) {	
-					map(sensorValue, 0, sensorThreshold, rule->offColor.red,   rule->offFadeColor.red),
-					map(sensorValue, 0, sensorThreshold, rule->offColor.green, rule->offFadeColor.green),
-					map(sensorValue, 0, sensorThreshold, rule->offColor.blue,  rule->offFadeColor.blue)
-				};
-			}
-			else {
-				color = rule->offColor;
-			}
+			color = (rule->flags & LRF_FADE_OFF) ? Lights_FadeColor(rule->offColor, rule->offFadeColor, step) : rule->offColor;
 		}
 		
-		for (uint8_t led = mapping->ledIndexBegin; led < mapping->ledIndexEnd; ++led) {
-            LED_COLORS[led] = color;
+		if (memcmp(&color, &state->color, sizeof (rgb_color)) != 0) {
+			state->color = color;
+			changed = true;
 		}
 	}
 	
-	if(update || force) {
-		led_strip_write(LED_COLORS, LED_COUNT);
-	}
+	return changed;
 }
 
+// Called from the main loop. Runs at most once per USB frame, right after that frame's input report was handled,
+// and only writes the strip when a color changed, since the write blocks the main loop for a while.
+void Lights_Task(void)
+{
+	uint16_t frame = USB_Device_GetFrameNumber();
+	if (frame == lastSeenFrame && !forceWrite) {
+		return;
+	}
+	
+	lastSeenFrame = frame;
+	
+	if (((frame - lastUpdateFrame) & FRAME_NUMBER_MASK) < UPDATE_INTERVAL_FRAMES && !forceWrite) {
+		return;
+	}
+	
+	lastUpdateFrame = frame;
+	
+	uint32_t renderStart = Clock_Micros();
+	bool changed = Lights_Render();
+	Stats_Record(STATS_LIGHTS_RENDER, renderStart);
+	
+	if (!changed && !forceWrite) {
+		return;
+	}
+	
+	// Mappings may overlap, in which case the later one wins, so all of them are laid out again.
+	memset(LED_COLORS, 0, sizeof (LED_COLORS));
+	
+	for (uint8_t m = 0; m < MAX_LED_MAPPINGS; ++m)
+	{
+		const MappingState* state = &MAPPING_STATE[m];
+		
+		if (!state->enabled)
+			continue;
+		
+		for (uint8_t led = state->ledIndexBegin; led < state->ledIndexEnd; ++led) {
+			LED_COLORS[led] = state->color;
+		}
+	}
+	
+	uint32_t writeStart = Clock_Micros();
+	led_strip_write(LED_COLORS, LED_COUNT);
+	Stats_Record(STATS_LED_WRITE, writeStart);
+	forceWrite = false;
+}
 
 #else
 void Lights_UpdateConfiguration(const LightConfiguration* lightConfiguration) { ; }
-void Lights_Update(bool force) { ; }
+void Lights_Task(void) { ; }
+void Lights_UpdateThresholds(void) { ; }
 #endif
\ No newline at end of file
@@ -47,7 +47,8 @@ typedef struct
 } __attribute__((packed)) LightConfiguration;
 
 void Lights_UpdateConfiguration(const LightConfiguration* lightConfiguration);
-void Lights_Update(bool force);
+void Lights_UpdateThresholds(void);
+void Lights_Task(void);
 
 extern LightConfiguration LIGHT_CONF;
 
@@ -5,6 +5,7 @@
 #include "ConfigStore.h"
 #include "Pad.h"
 #include "ADC.h"
+#include "Clock.h"
 #include "Lights.h"
 
 #define MIN(a,b) ((a) < (b) ? a : b)
@@ -13,7 +14,8 @@ PadConfigurationV2 PAD_CONF;
 
 PadState PAD_STATE = { 
     .sensorValues = { [0 ... SENSOR_COUNT - 1] = 0 },
-    .buttonsPressed = { [0 ... BUTTON_COUNT - 1] = false }
+    .buttonsPressed = { [0 ... BUTTON_COUNT - 1] = false },
+    .buttonChangeTimes = { [0 ... BUTTON_COUNT - 1] = 0 }
 };
 
 typedef struct {
@@ -47,22 +49,49 @@ void Pad_UpdateInternalConfiguration(void) {
         // mark -1 to end
         INTERNAL_PAD_CONF.buttonToSensorMap[buttonIndex][mapIndex] = -1;
     }
+
+    // Precalculate which sensors the ADC has to scan. Sensors mapped to a button are active and scanned all the time.
+    // Unmapped sensors are idle, they are scanned just often enough to show their values when mapping buttons.
+    // Disabled and unconnected sensors are not scanned at all.
+    uint8_t activeSensors[SENSOR_COUNT];
+    uint8_t idleSensors[SENSOR_COUNT];
+    uint8_t activeCount = 0;
+    uint8_t idleCount = 0;
+
+    for (uint8_t sensorIndex = 0; sensorIndex < SENSOR_COUNT; sensorIndex++) {
+        SensorConfig s = PAD_CONF.sensors[sensorIndex];
+
+        if (!ADC_IsConnected(sensorIndex) || (s.flags & ADC_DISABLED)) {
+            continue;
+        }
+
+        if (s.buttonMapping >= 0 && s.buttonMapping < BUTTON_COUNT) {
+            activeSensors[activeCount++] = sensorIndex;
+        } else {
+            idleSensors[idleCount++] = sensorIndex;
+        }
+    }
+
+    ADC_SetSensors(activeSensors, activeCount, idleSensors, idleCount);
 }
 
 void Pad_Initialize(const PadConfigurationV2* padConfiguration) {
-    Pad_UpdateConfiguration(padConfiguration);
 	ADC_Init();
+    Pad_UpdateConfiguration(padConfiguration);
 }
 
 void Pad_UpdateConfiguration(const PadConfigurationV2* padConfiguration) {
     memcpy(&PAD_CONF, padConfiguration, sizeof (PadConfigurationV2));
     Pad_UpdateInternalConfiguration();
+
+    // Lights precalculate their fades from the sensor thresholds.
+    Lights_UpdateThresholds();
 }
 
 void Pad_UpdateState(void) {
-    for (int i = 0; i < SENSOR_COUNT; i++) {
-        PAD_STATE.sensorValues[i] = ADC_Read(i);
-    }
+    // The ADC scans all sensors in the background, just pick up the last complete scan.
+    ADC_ReadFrame(PAD_STATE.sensorValues);
+    uint16_t now = (uint16_t)Clock_Micros();
 
     for (int i = 0; i < BUTTON_COUNT; i++) {
         bool newButtonPressedState = false;
@@ -94,8 +123,11 @@ void Pad_UpdateState(void) {
             }
         }
 
+        // The time of the threshold crossing lets the host measure how long it took to report.
+        if (PAD_STATE.buttonsPressed[i] != newButtonPressedState) {
+            PAD_STATE.buttonChangeTimes[i] = now;
+        }
+
         PAD_STATE.buttonsPressed[i] = newButtonPressedState;
     }
-	
-	Lights_Update(false);
 }
@@ -7,9 +7,15 @@
 
 enum SensorConfigFlags
 {
-	ADC_DISABLED     = 0x1
+	ADC_DISABLED     = 0x1,
+	ADC_MEDIAN_FILTER = 0x2
 };
 
+// Bits 4-6 of the sensor flags hold the oversampling shift, 2^shift samples are averaged into every sensor value.
+#define ADC_OVERSAMPLE_SHIFT_MASK 0x70
+#define ADC_OVERSAMPLE_SHIFT_OFFSET 4
+#define ADC_MAX_OVERSAMPLE_SHIFT 4
+
 typedef struct {
     uint16_t sensorThresholds[SENSOR_COUNT];
     float releaseMultiplier;
@@ -32,6 +38,7 @@ typedef struct {
 typedef struct {
     uint16_t sensorValues[SENSOR_COUNT];
     bool buttonsPressed[BUTTON_COUNT];
+    uint16_t buttonChangeTimes[BUTTON_COUNT]; // lower 16 bits of Clock_Micros when the button was last pressed or released
 } PadState;
 
 void Pad_Initialize(const PadConfigurationV2* padConfiguration);
@@ -0,0 +1,76 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "Stats.h"
+#include "ADC.h"
+#include "Clock.h"
+
+// Averages and rates are taken over windows of this many microseconds.
+#define STATS_WINDOW_US 1000000UL
+
+typedef struct {
+    uint32_t totalMicros;
+    uint32_t runs;
+} StageWindow;
+
+static StageWindow stageWindows[STATS_STAGE_COUNT];
+static StageStats stageStats[STATS_STAGE_COUNT];
+static uint32_t windowStart = 0;
+static uint16_t adcConversionsPerSecond = 0;
+
+static uint16_t Stats_Saturate(uint32_t value) {
+    return value > 0xFFFF ? 0xFFFF : (uint16_t)value;
+}
+
+void Stats_Reset(void) {
+    memset(stageWindows, 0, sizeof (stageWindows));
+    memset(stageStats, 0, sizeof (stageStats));
+    windowStart = Clock_Micros();
+    ADC_TakeConversionCount();
+    adcConversionsPerSecond = 0;
+}
+
+// Called from the main loop. Closes the current window once a second, the division only happens then.
+void Stats_Task(void) {
+    uint32_t now = Clock_Micros();
+    if (now - windowStart < STATS_WINDOW_US) {
+        return;
+    }
+
+    windowStart = now;
+
+    for (uint8_t i = 0; i < STATS_STAGE_COUNT; i++) {
+        StageWindow* window = &stageWindows[i];
+        StageStats* stats = &stageStats[i];
+
+        stats->averageMicros = window->runs ? Stats_Saturate(window->totalMicros / window->runs) : 0;
+        stats->runsPerSecond = window->runs;
+
+        window->totalMicros = 0;
+        window->runs = 0;
+    }
+
+    adcConversionsPerSecond = ADC_TakeConversionCount();
+}
+
+// Adds a run of the given stage that started at the given Clock_Micros time and ends now.
+void Stats_Record(uint8_t stage, uint32_t startTime) {
+    uint32_t elapsed = Clock_Micros() - startTime;
+    StageWindow* window = &stageWindows[stage];
+
+    window->totalMicros += elapsed;
+    window->runs++;
+
+    uint16_t micros = Stats_Saturate(elapsed);
+    if (micros > stageStats[stage].maxMicros) {
+        stageStats[stage].maxMicros = micros;
+    }
+}
+
+void Stats_ReadStages(StageStats* stages) {
+    memcpy(stages, stageStats, sizeof (stageStats));
+}
+
+uint16_t Stats_AdcConversionsPerSecond(void) {
+    return adcConversionsPerSecond;
+}
@@ -0,0 +1,27 @@
+#ifndef _STATS_H_
+#define _STATS_H_
+    #include <stdint.h>
+
+    // Parts of the firmware whose run time is measured with Clock_Micros.
+    enum StatsStage {
+        STATS_MAIN_LOOP,     // one pass through the main loop
+        STATS_PAD_UPDATE,    // Pad_UpdateState, once per ADC scan
+        STATS_LIGHTS_RENDER, // Lights_Render, every few frames
+        STATS_LED_WRITE,     // led_strip_write, only when a color changed
+        STATS_EEPROM_WRITE,  // from starting an eeprom byte write until the main loop next sees the eeprom ready, so
+                             // the write time plus however long the main loop took to get back to it
+        STATS_STAGE_COUNT
+    };
+
+    typedef struct {
+        uint16_t averageMicros; // over the last second
+        uint16_t maxMicros;     // since power up or the last reset
+        uint32_t runsPerSecond;
+    } __attribute__((packed)) StageStats;
+
+    void Stats_Reset(void);
+    void Stats_Task(void);
+    void Stats_Record(uint8_t stage, uint32_t startTime);
+    void Stats_ReadStages(StageStats* stages);
+    uint16_t Stats_AdcConversionsPerSecond(void);
+#endif